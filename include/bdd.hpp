@@ -0,0 +1,83 @@
+#ifndef BDD_HPP
+#define BDD_HPP
+
+#include "func.hpp"
+#include "model.hpp"
+#include <any>
+#include <map>
+#include <tuple>
+#include <vector>
+
+// a reduced ordered binary decision diagram over bool variables
+struct bdd
+{
+    // a decision node, branching on a variable
+    struct node
+    {
+        size_t m_var;
+        size_t m_low;
+        size_t m_high;
+    };
+
+    // the ids of the terminal nodes
+    static constexpr size_t FALSE_NODE = 0;
+    static constexpr size_t TRUE_NODE = 1;
+
+    // all nodes, indexed by id (the first two are the terminals)
+    std::vector<node> m_nodes;
+
+    // the variable at each level, and the level of each variable
+    std::vector<size_t> m_order;
+    std::vector<size_t> m_levels;
+
+    // (var, low, high) -> id, guarantees that nodes are shared
+    std::map<std::tuple<size_t, size_t, size_t>, size_t> m_unique_table;
+
+    // (f, g, h) -> ite(f, g, h), caches previous operations
+    std::map<std::tuple<size_t, size_t, size_t>, size_t> m_computed_table;
+
+    // construct an empty diagram with the given variable order
+    bdd(const std::vector<size_t>& a_order);
+
+    // get the (reduced, shared) node for a decision
+    size_t make_node(size_t a_var, size_t a_low, size_t a_high);
+
+    // get the node for a single variable
+    size_t var(size_t a_var);
+
+    // if-then-else, from which all other operators are derived
+    size_t ite(size_t a_f, size_t a_g, size_t a_h);
+
+    // negate a node
+    size_t negate(size_t a_f);
+
+    // build the node for a bool-returning func over bool params
+    size_t from_func(const func& a_func);
+
+    // build the node for a model whose bins are funcs over bool params
+    size_t from_model(const model& a_model);
+
+    // rebuild a node into another diagram (e.g. with a new order)
+    size_t transfer(size_t a_root, bdd& a_target) const;
+
+    // evaluate a node on bool params
+    bool eval(size_t a_root, const std::any* a_params,
+              size_t a_param_count) const;
+
+    // count the decision nodes reachable from a node
+    size_t size(size_t a_root) const;
+};
+
+// variables in index order
+std::vector<size_t> natural_order(size_t a_var_count);
+
+// variables in the order they are first used by the model's bins
+std::vector<size_t> first_use_order(const model& a_model, size_t a_var_count);
+
+// improve the order of a diagram by sifting each variable
+std::vector<size_t> sift(const bdd& a_bdd, size_t a_root);
+
+// check if two models over bool params compute the same function
+bool equivalent(const model& a_lhs, const model& a_rhs, size_t a_var_count);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "choice.hpp"
+#include "model.hpp"
+#include "program.hpp"
+#include "scope.hpp"
+#include "search_tree.hpp"
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <string>
+#include <typeindex>
+
+// everything a search needs to continue exactly where it left off,
+// besides the program of the best model
+struct search_state
+{
+    size_t m_iteration = 0;
+    std::mt19937 m_rnd_gen;
+    search_tree<choice> m_tree;
+    double m_best_reward = -std::numeric_limits<double>::infinity();
+    model m_best_model;
+};
+
+// write the state, the best program and its scope as text. funcs are
+// written by repr rather than by address, and the funcs of the original
+// program are left out, since the caller rebuilds them. the funcs of the
+// scope must be in the best program.
+void write_checkpoint(std::ostream& a_stream, const search_state& a_state,
+                      const program& a_best_program, const scope& a_best_scope,
+                      const program& a_original_program);
+
+// read what write_checkpoint wrote. funcs are looked up by repr in the
+// original program, and the funcs added to it (binning functions) take
+// the given param types.
+void read_checkpoint(
+    std::istream& a_stream, search_state& a_state, program& a_best_program,
+    scope& a_best_scope, const program& a_original_program,
+    const std::multimap<std::type_index, size_t>& a_param_types);
+
+// write a checkpoint to a temporary file, then rename it over the path,
+// so that being stopped mid-write leaves the previous one intact
+void save_checkpoint(const std::string& a_path, const search_state& a_state,
+                     const program& a_best_program, const scope& a_best_scope,
+                     const program& a_original_program);
+
+// read a checkpoint from the path, returns false if there is none
+bool load_checkpoint(
+    const std::string& a_path, search_state& a_state, program& a_best_program,
+    scope& a_best_scope, const program& a_original_program,
+    const std::multimap<std::type_index, size_t>& a_param_types);
+
+#endif
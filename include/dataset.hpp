@@ -0,0 +1,368 @@
+#ifndef DATASET_HPP
+#define DATASET_HPP
+
+#include "intern.hpp"
+#include <any>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <typeindex>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// store a value in an any, in place if it already holds one of its type
+template <typename T>
+inline void assign_any(std::any& a_any, const T& a_value)
+{
+    // REASON: assigning to an any constructs a new one and swaps it in,
+    // which costs more than the evaluation of many primitives
+    if(T* l_held = std::any_cast<T>(&a_any))
+        *l_held = a_value;
+    else
+        a_any = a_value;
+}
+
+// a column of lists, stored as the values of every list back to back and
+// the offset at which each list starts. lists are read as spans into the
+// values, so that they are never copied.
+template <typename T>
+struct ragged_column
+{
+    using value_type = std::span<const T>;
+
+    // the offset of each list, then one past the last
+    std::vector<size_t> m_offsets{0};
+    std::vector<T> m_values;
+
+    // the number of lists
+    size_t size() const
+    {
+        return m_offsets.size() - 1;
+    }
+
+    std::span<const T> operator[](size_t a_row) const
+    {
+        return std::span<const T>(m_values).subspan(
+            m_offsets[a_row], m_offsets[a_row + 1] - m_offsets[a_row]);
+    }
+
+    void push_back(std::span<const T> a_list)
+    {
+        m_values.insert(m_values.end(), a_list.begin(), a_list.end());
+        m_offsets.push_back(m_values.size());
+    }
+
+    void reserve(size_t a_size)
+    {
+        m_offsets.reserve(a_size + 1);
+    }
+
+    bool operator==(const ragged_column&) const = default;
+};
+
+// the types a column can hold: bool, int, double, std::string,
+// interned_string and lists of ints, which are read as
+// std::span<const int>
+enum class column_type
+{
+    boolean,
+    integer,
+    real,
+    string,
+    interned,
+    integer_list,
+};
+
+// the values of a column, packed by type, in the order of column_type
+using column =
+    std::variant<std::vector<bool>, std::vector<int>, std::vector<double>,
+                 std::vector<std::string>, std::vector<interned_string>,
+                 ragged_column<int>>;
+
+// which columns of a file are the params, in order of param index, and
+// which one is the label
+struct data_schema
+{
+    struct column_spec
+    {
+        std::string m_name;
+        column_type m_type;
+    };
+
+    std::vector<column_spec> m_params;
+    std::string m_label;
+
+    // the param types, as learn_model takes them
+    std::multimap<std::type_index, size_t> param_types() const;
+};
+
+// data points stored by column rather than by row, so that each value
+// takes only the space of its type
+struct dataset
+{
+    data_schema m_schema;
+
+    // one column per param of the schema
+    std::vector<column> m_columns;
+    std::vector<bool> m_labels;
+
+    // the strings of the interned columns, shared by copies
+    std::shared_ptr<string_pool> m_strings = std::make_shared<string_pool>();
+
+    // the number of data points
+    size_t size() const;
+
+    // write the params of a row into a_values, one per column
+    void fill_row(size_t a_row, std::any* a_values) const;
+
+    // every data point, as learn_model takes them
+    std::vector<std::pair<std::vector<std::any>, bool>> rows() const;
+};
+
+////////////////////////////////////////////////////
+/////////////////////// CSV ////////////////////////
+////////////////////////////////////////////////////
+
+// read the columns of the schema from a csv with a header row. the text
+// is read a chunk at a time, and each batch of chunks is parsed on
+// separate threads straight into typed columns.
+dataset read_csv(
+    std::istream& a_stream, const data_schema& a_schema,
+    const size_t& a_thread_count = std::thread::hardware_concurrency(),
+    const size_t& a_chunk_size = size_t{1} << 22);
+
+dataset read_csv(
+    const std::string& a_path, const data_schema& a_schema,
+    const size_t& a_thread_count = std::thread::hardware_concurrency(),
+    const size_t& a_chunk_size = size_t{1} << 22);
+
+////////////////////////////////////////////////////
+//////////////////// COLUMN FILES //////////////////
+////////////////////////////////////////////////////
+
+// write a dataset as binary columns, each aligned to 8 bytes: bools and
+// labels as bitsets, numbers at their native width, and strings, interned
+// or not, as indices into a dictionary of their distinct values
+void write_columns(std::ostream& a_stream, const dataset& a_dataset);
+
+// read what write_columns wrote into memory
+dataset read_columns(std::istream& a_stream);
+
+void write_columns(const std::string& a_path, const dataset& a_dataset);
+
+dataset read_columns(const std::string& a_path);
+
+// the columns of a column file, read in place from its bytes, which must
+// outlive it and be 8 byte aligned
+struct column_file
+{
+    struct column_view
+    {
+        column_type m_type;
+
+        // a bitset, int32s, doubles, uint32 dictionary indices, or the
+        // uint64 offsets of lists
+        const void* m_values;
+
+        // the values of the lists of a list column, back to back
+        const int32_t* m_list_values = nullptr;
+        uint64_t m_list_value_count = 0;
+
+        // the distinct strings of a string column
+        std::vector<std::string> m_dictionary;
+
+        // the distinct strings of an interned column, whose ids are
+        // their indices in the file
+        std::shared_ptr<string_pool> m_strings;
+    };
+
+    data_schema m_schema;
+    size_t m_size;
+    std::vector<column_view> m_columns;
+    const uint64_t* m_labels;
+
+    // find the columns in the bytes, checking that they fit
+    column_file(const char* a_bytes, const size_t& a_size);
+
+    // the number of data points
+    size_t size() const;
+
+    bool label(size_t a_row) const;
+
+    // write the params of a row into a_values, one per column
+    void fill_row(size_t a_row, std::any* a_values) const;
+};
+
+// a whole file mapped read-only into memory
+struct file_mapping
+{
+    const char* m_bytes;
+    size_t m_size;
+
+    file_mapping(const std::string& a_path);
+    ~file_mapping();
+
+    file_mapping(const file_mapping&) = delete;
+    file_mapping& operator=(const file_mapping&) = delete;
+};
+
+// a column file used where it lies on disk. opening it reads only the
+// header, pages are loaded as they are touched, and they are shared by
+// every process mapping the same file.
+struct mapped_dataset
+{
+    file_mapping m_mapping;
+    column_file m_file;
+
+    mapped_dataset(const std::string& a_path);
+};
+
+////////////////////////////////////////////////////
+/////////////////// TYPED DATASETS /////////////////
+////////////////////////////////////////////////////
+
+// how a typed dataset stores a column of a param type
+template <typename T>
+struct column_storage
+{
+    using type = std::vector<T>;
+};
+
+// spans are stored as the lists they view
+template <typename T>
+struct column_storage<std::span<const T>>
+{
+    using type = ragged_column<T>;
+};
+
+// data points whose param types are known at compile time, stored as a
+// column of each type, so that they hold no std::any
+template <typename... Params>
+struct typed_dataset
+{
+    std::tuple<typename column_storage<Params>::type...> m_columns;
+    std::vector<bool> m_labels;
+
+    // the number of data points
+    size_t size() const
+    {
+        return m_labels.size();
+    }
+
+    // write the params of a row into a_values, one per column
+    void fill_row(size_t a_row, std::any* a_values) const
+    {
+        fill_row(a_row, a_values, std::index_sequence_for<Params...>());
+    }
+
+    template <size_t... Indices>
+    void fill_row(size_t a_row, std::any* a_values,
+                  std::index_sequence<Indices...>) const
+    {
+        (assign_any(a_values[Indices], std::get<Indices>(m_columns)[a_row]),
+         ...);
+    }
+};
+
+// split rows of params into typed columns
+template <typename... Params>
+typed_dataset<Params...>
+make_typed_dataset(const std::vector<std::tuple<Params...>>& a_rows,
+                   const std::vector<bool>& a_labels)
+{
+    if(a_rows.size() != a_labels.size())
+        throw std::runtime_error("Error: rows and labels differ in count.");
+
+    typed_dataset<Params...> l_dataset{.m_labels = a_labels};
+
+    std::apply([&a_rows](auto&... a_columns)
+               { (a_columns.reserve(a_rows.size()), ...); },
+               l_dataset.m_columns);
+
+    for(const std::tuple<Params...>& l_row : a_rows)
+        [&]<size_t... Indices>(std::index_sequence<Indices...>)
+        {
+            (std::get<Indices>(l_dataset.m_columns)
+                 .push_back(std::get<Indices>(l_row)),
+             ...);
+        }(std::index_sequence_for<Params...>());
+
+    return l_dataset;
+}
+
+////////////////////////////////////////////////////
+///////////////////// DATA VIEW ////////////////////
+////////////////////////////////////////////////////
+
+// the data points the learner reads, wherever they are stored. rows are
+// read in place, and columns are read a row at a time into a buffer, so
+// no source is copied. the source must outlive the view.
+struct data_view
+{
+    // a source whose type is only known where the view is made, read
+    // through functions instantiated there
+    struct typed_source
+    {
+        const void* m_data;
+        size_t m_size;
+        size_t m_param_count;
+        bool (*m_label)(const void*, size_t);
+        void (*m_fill_row)(const void*, size_t, std::any*);
+    };
+
+    std::variant<const std::vector<std::pair<std::vector<std::any>, bool>>*,
+                 const dataset*, const column_file*, typed_source>
+        m_source;
+
+    data_view(
+        const std::vector<std::pair<std::vector<std::any>, bool>>& a_rows);
+    data_view(const dataset& a_dataset);
+    data_view(const column_file& a_file);
+    data_view(const mapped_dataset& a_dataset);
+
+    template <typename... Params>
+    data_view(const typed_dataset<Params...>& a_dataset)
+        : m_source(typed_source{
+              .m_data = &a_dataset,
+              .m_size = a_dataset.size(),
+              .m_param_count = sizeof...(Params),
+              .m_label = [](const void* a_data, size_t a_row) -> bool
+              {
+                  return static_cast<const typed_dataset<Params...>*>(a_data)
+                      ->m_labels[a_row];
+              },
+              .m_fill_row =
+                  [](const void* a_data, size_t a_row, std::any* a_values)
+              {
+                  static_cast<const typed_dataset<Params...>*>(a_data)
+                      ->fill_row(a_row, a_values);
+              },
+          })
+    {
+    }
+
+    // the number of data points
+    size_t size() const;
+
+    // the largest number of params of a row
+    size_t param_count() const;
+
+    bool label(size_t a_row) const;
+
+    // the params of a row. a_buffer holds param_count() values, which
+    // are overwritten unless the source stores rows.
+    std::span<const std::any> params(size_t a_row, std::any* a_buffer) const;
+
+    // every data point, as rows. spans in them still view the source.
+    std::vector<std::pair<std::vector<std::any>, bool>> rows() const;
+};
+
+#endif
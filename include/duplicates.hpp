@@ -0,0 +1,39 @@
+#ifndef DUPLICATES_HPP
+#define DUPLICATES_HPP
+
+#include "dataset.hpp"
+#include <stdexcept>
+#include <vector>
+
+// the distinct data points of a view. rows of equal params and labels
+// are collapsed into the first of them, and rows of equal params but
+// different labels, which no model can separate, are conflicts.
+struct unique_rows
+{
+    // the first row of each distinct data point, in order
+    std::vector<size_t> m_rows;
+
+    // the number of rows collapsed into each
+    std::vector<size_t> m_weights;
+
+    // the rows sharing the params of each conflict, in order
+    std::vector<std::vector<size_t>> m_conflicts;
+};
+
+// find the distinct data points by hashing the params of every row.
+// only params of the types of dataset columns are compared, so rows
+// holding params of other types are never collapsed.
+unique_rows collapse_duplicates(const data_view& a_data);
+
+// rows of equal params but different labels. the data rather than the
+// search is at fault, so every search of it fails alike.
+struct conflicting_rows : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+// throw conflicting_rows if there are conflicts, naming the rows of the
+// first
+void check_conflicts(const unique_rows& a_unique);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef ENUMERATE_HPP
+#define ENUMERATE_HPP
+
+#include "func.hpp"
+#include "model.hpp"
+#include "program.hpp"
+#include "scope.hpp"
+#include <any>
+#include <map>
+#include <optional>
+#include <typeindex>
+#include <vector>
+
+// enumerates binning function bodies bottom-up, in order of increasing
+// node count. terms whose values over the data are the same as those of
+// a smaller term are discarded. returns the first term which perfectly
+// separates the data, otherwise the smallest term which splits the data
+// into two non-empty bins, otherwise nothing.
+std::optional<func::body> enumerate_binning_function(
+    const scope& a_scope,
+    const std::multimap<std::type_index, size_t>& a_param_types,
+    const std::vector<std::pair<std::vector<std::any>, bool>>& a_data,
+    const size_t& a_max_size);
+
+// builds a model as build_model does, but finds each binning function
+// by enumeration rather than by search
+model enumerate_model(
+    program& a_program, const scope& a_scope,
+    const std::multimap<std::type_index, size_t>& a_param_types,
+    const std::vector<std::pair<std::vector<std::any>, bool>>& a_data,
+    const size_t& a_max_size);
+
+#endif
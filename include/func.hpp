@@ -4,10 +4,13 @@
 #include <any>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <typeindex>
 #include <variant>
 
+struct primitive_profile;
+
 // contains total information about a function
 struct func
 {
@@ -21,6 +24,25 @@ struct func
     struct primitive
     {
         std::function<std::any(const std::any*, size_t)> m_defn;
+
+        // builds an m_defn which records into a profile
+        std::function<std::function<std::any(const std::any*, size_t)>(
+            const std::shared_ptr<primitive_profile>&)>
+            m_make_profiled;
+    };
+
+    // properties of a primitive, declared when it is added
+    struct properties
+    {
+        // the args may be given in any order
+        bool m_commutative = false;
+
+        // f(f(a, b), c) is f(a, f(b, c))
+        bool m_associative = false;
+
+        // the cost of a call, not counting its args, relative to reading
+        // a param
+        double m_cost = 1;
     };
 
     // represents a function definition
@@ -37,6 +59,13 @@ struct func
 
         // count the number of nodes in the body
         size_t node_count() const;
+
+        // the cost of evaluating the body. params and primitives held
+        // directly cost 1, so with default costs this is the node count.
+        double cost() const;
+
+        // representation of the body
+        std::string repr() const;
     };
 
     // the parameters
@@ -44,6 +73,9 @@ struct func
     std::multimap<std::type_index, size_t> m_param_types;
     body m_body;
     std::string m_repr;
+    properties m_properties;
+    // the cost of a call, not counting its args
+    double cost() const;
     // normal constructor
     func(const std::type_index& a_return_type,
          const std::multimap<std::type_index, size_t>& a_param_types,
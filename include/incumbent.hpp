@@ -0,0 +1,41 @@
+#ifndef INCUMBENT_HPP
+#define INCUMBENT_HPP
+
+#include "model.hpp"
+#include "program.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+// the best model found so far, shared between concurrent searches
+struct incumbent
+{
+    // the reward of the best model (readable without locking)
+    std::atomic<double> m_reward;
+
+    // searches stop once this time has passed
+    std::chrono::steady_clock::time_point m_deadline;
+
+    // searches stop once the reward reaches this bound
+    double m_target_reward;
+
+    // guards the best program and model
+    std::mutex m_mutex;
+
+    // the best program and model
+    program m_program;
+    model m_model;
+
+    // normal constructor
+    incumbent(const std::chrono::steady_clock::time_point& a_deadline,
+              const double& a_target_reward);
+
+    // keep the model if it is better than the best, returns true if kept
+    bool offer(const double& a_reward, const program& a_program,
+               const model& a_model);
+
+    // check if the deadline has passed or the target has been reached
+    bool should_stop() const;
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef INTERN_HPP
+#define INTERN_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct string_pool;
+
+// a string stored once in a pool, passed around by handle. copying one
+// copies a pointer, and the handles of equal strings of one pool are
+// equal. the pool must outlive its handles.
+struct interned_string
+{
+    struct entry
+    {
+        std::string m_string;
+        const string_pool* m_pool;
+
+        // the index of the string in its pool
+        uint32_t m_id;
+    };
+
+    // REASON: a single pointer, so that std::any stores it inline
+    // rather than on the heap
+    const entry* m_entry = nullptr;
+
+    std::string_view view() const
+    {
+        return m_entry ? std::string_view(m_entry->m_string)
+                       : std::string_view();
+    }
+
+    size_t size() const
+    {
+        return view().size();
+    }
+
+    uint32_t id() const
+    {
+        return m_entry ? m_entry->m_id : 0;
+    }
+
+    const string_pool* pool() const
+    {
+        return m_entry ? m_entry->m_pool : nullptr;
+    }
+
+    bool operator==(const interned_string& a_other) const
+    {
+        if(m_entry == a_other.m_entry)
+            return true;
+
+        // REASON: a pool holds each string once, so the strings of one
+        // pool are only compared across pools
+        if(pool() != nullptr && pool() == a_other.pool())
+            return false;
+
+        return view() == a_other.view();
+    }
+
+    bool operator<(const interned_string& a_other) const
+    {
+        return view() < a_other.view();
+    }
+};
+
+// the distinct strings of a dataset, in order of first appearance. not
+// thread safe.
+struct string_pool
+{
+    // REASON: a deque never moves its elements, so handles and the keys
+    // of m_ids stay valid as the pool grows
+    std::deque<interned_string::entry> m_entries;
+    std::unordered_map<std::string_view, uint32_t> m_ids;
+
+    // REASON: unlike its address, never shared with another pool, even
+    // one made after this is destroyed
+    uint64_t m_generation;
+
+    string_pool();
+    string_pool(const string_pool&) = delete;
+    string_pool& operator=(const string_pool&) = delete;
+
+    // the handle of a string, adding it if it is new
+    interned_string intern(std::string_view a_string);
+
+    // the handle of the string with the given id
+    interned_string at(uint32_t a_id) const;
+
+    // the number of distinct strings
+    size_t size() const;
+};
+
+// a pure function of a string, computed once per distinct string of a
+// pool. the results of every pool seen are kept, by its generation.
+template <typename Ret>
+std::function<Ret(interned_string)>
+memoize_interned(const std::function<Ret(std::string_view)>& a_function)
+{
+    struct cache
+    {
+        // REASON: primitives are shared between the threads of a
+        // portfolio, so the cache is too. once every string is seen it
+        // is only read, so readers share the lock.
+        std::shared_mutex m_mutex;
+        std::unordered_map<uint64_t, std::vector<std::optional<Ret>>>
+            m_results;
+    };
+
+    auto l_cache = std::make_shared<cache>();
+
+    return [a_function, l_cache](interned_string a_string) -> Ret
+    {
+        if(a_string.pool() == nullptr)
+            return a_function(a_string.view());
+
+        uint64_t l_generation = a_string.pool()->m_generation;
+
+        {
+            std::shared_lock<std::shared_mutex> l_lock(l_cache->m_mutex);
+
+            auto l_results = l_cache->m_results.find(l_generation);
+
+            if(l_results != l_cache->m_results.end() &&
+               a_string.id() < l_results->second.size() &&
+               l_results->second[a_string.id()])
+                return *l_results->second[a_string.id()];
+        }
+
+        Ret l_result = a_function(a_string.view());
+
+        std::unique_lock<std::shared_mutex> l_lock(l_cache->m_mutex);
+
+        std::vector<std::optional<Ret>>& l_results =
+            l_cache->m_results[l_generation];
+
+        if(a_string.id() >= l_results.size())
+            l_results.resize(a_string.id() + 1);
+
+        l_results[a_string.id()] = l_result;
+
+        return l_result;
+    };
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MINIMIZE_HPP
+#define MINIMIZE_HPP
+
+#include "func.hpp"
+#include <any>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// a product of literals over bool params
+struct cube
+{
+    // the params which appear in the product (param i is bit i)
+    uint64_t m_care;
+
+    // the required values of the params which appear
+    uint64_t m_value;
+
+    // check if the cube contains a row key
+    bool covers(uint64_t a_key) const;
+};
+
+// find a small sum of products that is true on the true rows and false
+// on the false rows of bool data. rows which are missing from the data
+// are don't-cares.
+std::vector<cube>
+minimize_sop(const std::vector<std::pair<std::vector<std::any>, bool>>& a_data);
+
+// build a binning function from a sum of products over bool params
+std::shared_ptr<func> make_sop_function(const std::vector<cube>& a_cover,
+                                        size_t a_param_count,
+                                        const func* a_and, const func* a_or,
+                                        const func* a_not);
+
+#endif
@@ -16,12 +16,26 @@ struct model
     std::shared_ptr<model> m_negative_child;
     std::shared_ptr<model> m_positive_child;
 
+    // the number of training data points a leaf misclassifies, which is
+    // nonzero only if it was left impure
+    size_t m_error_count = 0;
+
     // the function to evaluate the model
-    bool eval(const std::any* a_params, size_t a_param_count);
+    bool eval(const std::any* a_params, size_t a_param_count) const;
 
     // get the node count
     size_t node_count() const;
 
+    // get the number of binning functions on the longest path
+    size_t depth() const;
+
+    // the number of training data points the leaves misclassify
+    size_t error_count() const;
+
+    // the cost of evaluating the model on a data point: 1 for each
+    // node on its path, plus the cost of each binning function called
+    double cost(const std::any* a_params, size_t a_param_count) const;
+
     // representation of the model
     std::string repr() const;
 };
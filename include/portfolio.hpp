@@ -0,0 +1,86 @@
+#ifndef PORTFOLIO_HPP
+#define PORTFOLIO_HPP
+
+#include "duplicates.hpp"
+#include "incumbent.hpp"
+#include "reduce.hpp"
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// races one search per config on separate threads. all searches share
+// an incumbent, which they prune against and which stops them once the
+// budget is spent or the target reward is reached. if there is a trace,
+// each search records its spans under its own thread.
+template <typename... Params>
+model learn_model_portfolio(
+    program& a_program, scope& a_scope,
+    const std::vector<std::pair<std::vector<std::any>, bool>>& a_data,
+    const std::vector<search_config>& a_configs,
+    const std::chrono::steady_clock::duration& a_budget,
+    const double& a_target_reward = std::numeric_limits<double>::infinity(),
+    trace* a_trace = nullptr)
+{
+    incumbent l_incumbent(std::chrono::steady_clock::now() + a_budget,
+                          a_target_reward);
+
+    // give each search its own program and scope
+    std::vector<program> l_programs(a_configs.size(), a_program);
+    std::vector<scope> l_scopes(a_configs.size(), a_scope);
+
+    std::vector<std::thread> l_workers;
+
+    // any other failure of each search, rethrown once all have stopped
+    std::vector<std::exception_ptr> l_errors(a_configs.size());
+
+    for(size_t i = 0; i < a_configs.size(); ++i)
+    {
+        l_workers.emplace_back(
+            [&, i]()
+            {
+                try
+                {
+                    learn_model<Params...>(l_programs[i], l_scopes[i], a_data,
+                                           a_configs[i], nullptr,
+                                           &l_incumbent, nullptr, a_trace);
+                }
+                catch(const conflicting_rows&)
+                {
+                    // REASON: every engine fails alike on such data, so
+                    // the rows are reported rather than the budget
+                    l_errors[i] = std::current_exception();
+                }
+                catch(const std::runtime_error&)
+                {
+                    // REASON: an engine which fails (e.g. enumeration
+                    // finding nothing within its size) leaves the race
+                }
+                catch(...)
+                {
+                    // REASON: an exception escaping a thread terminates
+                    // the process
+                    l_errors[i] = std::current_exception();
+                }
+            });
+    }
+
+    for(std::thread& l_worker : l_workers)
+        l_worker.join();
+
+    for(const std::exception_ptr& l_error : l_errors)
+        if(l_error)
+            std::rethrow_exception(l_error);
+
+    if(l_incumbent.m_reward.load() == -std::numeric_limits<double>::infinity())
+        throw std::runtime_error("Error: no model found within the budget.");
+
+    // take the best program
+    a_program = l_incumbent.m_program;
+
+    return l_incumbent.m_model;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include <any>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct func;
+struct program;
+
+// call counts and latencies of a single primitive. updates are atomic,
+// since concurrent searches share the funcs of copied programs.
+struct primitive_profile
+{
+    // latencies are bucketed by powers of two of nanoseconds
+    static constexpr size_t BUCKET_COUNT = 64;
+
+    std::atomic<size_t> m_calls{0};
+
+    // time spent converting the args out of std::any
+    std::atomic<int64_t> m_conversion_ns{0};
+
+    // time spent in the primitive itself
+    std::atomic<int64_t> m_call_ns{0};
+
+    // the number of calls with a latency in [2^(i-1), 2^i) nanoseconds
+    std::array<std::atomic<size_t>, BUCKET_COUNT> m_latency_buckets{};
+
+    // record a single call
+    void record(const std::chrono::nanoseconds& a_conversion,
+                const std::chrono::nanoseconds& a_call);
+
+    // an upper bound on the latency of the given fraction of calls
+    std::chrono::nanoseconds percentile(const double& a_fraction) const;
+};
+
+// profiles of primitives, by repr
+struct profiler
+{
+    // REASON: shared with the profiled definitions, so that a definition
+    // outliving the profiler never records into a destroyed profile
+    std::map<std::string, std::shared_ptr<primitive_profile>> m_profiles;
+
+    // the profile of a primitive, added if it has none
+    primitive_profile& profile(const std::string& a_repr);
+
+    // a table of the profiles, slowest in total first
+    std::string repr() const;
+};
+
+// like make_general_function, but times the arg conversion and the
+// call separately
+template <typename Ret, typename... Params>
+std::function<std::any(const std::any*, size_t)>
+make_profiled_function(std::function<Ret(Params...)> a_function,
+                       std::shared_ptr<primitive_profile> a_profile)
+{
+    return [a_function, a_profile](const std::any* a_params,
+                                   size_t) -> std::any
+    {
+        auto l_start = std::chrono::steady_clock::now();
+
+        // convert every arg before calling
+        auto l_args = [a_params]<size_t... Is>(std::index_sequence<Is...>)
+        {
+            return std::tuple<std::decay_t<Params>...>(
+                std::any_cast<std::decay_t<Params>>(a_params[Is])...);
+        }(std::index_sequence_for<Params...>());
+
+        auto l_converted = std::chrono::steady_clock::now();
+
+        std::any l_result = std::apply(a_function, l_args);
+
+        auto l_end = std::chrono::steady_clock::now();
+
+        a_profile->record(l_converted - l_start, l_end - l_converted);
+
+        return l_result;
+    };
+}
+
+// the definitions of profiled primitives, which are put back when this
+// is destroyed
+struct profiled_primitives
+{
+    std::vector<std::pair<std::shared_ptr<func>,
+                          std::function<std::any(const std::any*, size_t)>>>
+        m_definitions;
+
+    profiled_primitives() = default;
+    profiled_primitives(profiled_primitives&&) = default;
+    profiled_primitives& operator=(profiled_primitives&&) = delete;
+    profiled_primitives(const profiled_primitives&) = delete;
+    profiled_primitives& operator=(const profiled_primitives&) = delete;
+
+    ~profiled_primitives();
+};
+
+// replace the definition of every primitive in the program with one
+// that records into the profiler, until the result is destroyed. the
+// funcs are shared by every copy of the program, so no search may use
+// them meanwhile.
+[[nodiscard]] profiled_primitives profile_primitives(program& a_program,
+                                                     profiler& a_profiler);
+
+// declare the cost of every profiled primitive as its mean time per call,
+// relative to that of the cheapest. primitives never called keep their
+// cost.
+void calibrate_costs(program& a_program, const profiler& a_profiler);
+
+#endif
@@ -2,9 +2,11 @@
 #define ENV_HPP
 
 #include "../include/func.hpp"
+#include "../include/profile.hpp"
 #include <any>
 #include <list>
 #include <memory>
+#include <stdexcept>
 
 template <typename Ret>
 std::function<std::any(const std::any*, size_t)>
@@ -22,8 +24,11 @@ make_general_function(std::function<Ret(FirstParam, RestParams...)> a_function)
         [a_function](const std::any* a_params, size_t a_param_count) -> std::any
     {
         // curry the function
+        // REASON: captured by reference, since the curried function
+        // only lives for this call, and copying a_function copies
+        // everything it captured
         std::function<Ret(RestParams...)> l_function =
-            [a_function, a_params](RestParams... a_rest_params) -> Ret
+            [&a_function, a_params](RestParams... a_rest_params) -> Ret
         {
             return a_function(std::any_cast<FirstParam>(*a_params),
                               a_rest_params...);
@@ -42,7 +47,8 @@ struct program
     // adding functions
     template <typename Ret, typename... Params>
     func* add_primitive(const std::string& a_repr,
-                        const std::function<Ret(Params...)>& a_func)
+                        const std::function<Ret(Params...)>& a_func,
+                        const func::properties& a_properties = {})
     {
         // return type
         std::type_index l_return_type = typeid(Ret);
@@ -58,11 +64,39 @@ struct program
         for(size_t i = 0; i < l_param_types_list.size(); ++i)
             l_param_types.emplace(l_param_types_list[i], i);
 
+        // args can only be reordered if they are of one type
+        if(a_properties.m_commutative &&
+           (l_param_types_list.size() < 2 ||
+            l_param_types.count(l_param_types_list.front()) !=
+                l_param_types_list.size()))
+            throw std::runtime_error("Error: a commutative primitive must "
+                                     "take two or more params of one type.");
+
+        // args can only be regrouped if they are results
+        if(a_properties.m_associative &&
+           (l_param_types_list.size() != 2 ||
+            l_param_types.count(l_return_type) != 2))
+            throw std::runtime_error("Error: an associative primitive must "
+                                     "take two params of its return type.");
+
+        // REASON: only here are the param types known, so the
+        // profiled definition must be made from here
+        auto l_make_profiled =
+            [a_func](const std::shared_ptr<primitive_profile>& a_profile)
+        { return make_profiled_function(a_func, a_profile); };
+
         // create the function
         auto l_func = std::make_shared<func>(
             l_return_type, l_param_types,
-            func::body{.m_functor = func::primitive{l_general_functor}},
+            func::body{
+                .m_functor =
+                    func::primitive{
+                        .m_defn = l_general_functor,
+                        .m_make_profiled = l_make_profiled,
+                    },
+            },
             a_repr);
+        l_func->m_properties = a_properties;
 
         // add the function to the program
         m_funcs.push_back(l_func);
@@ -1,34 +1,490 @@
 #ifndef REDUCE_HPP
 #define REDUCE_HPP
 
+#include "checkpoint.hpp"
+#include "dataset.hpp"
+#include "duplicates.hpp"
+#include "enumerate.hpp"
 #include "func.hpp"
+#include "incumbent.hpp"
+#include "model.hpp"
+#include "program.hpp"
+#include "scope.hpp"
+#include "search_stats.hpp"
+#include "search_tree.hpp"
+#include "trace.hpp"
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stop_token>
+#include <string>
 #include <variant>
 
 ////////////////////////////////////////////////////
-/////////////////// CHOICE TYPES ///////////////////
+////////////////// SEARCH CONFIG ///////////////////
 ////////////////////////////////////////////////////
-struct place_param_node
+
+// what the reward of a model measures
+enum class reward_mode
 {
-    size_t m_index;
+    // the negative number of nodes in the program and the model
+    node_count,
+
+    // the negative mean cost of evaluating the model on the data, so
+    // that the cheapest model to run is found rather than the smallest
+    inference_cost,
 };
-struct place_func_node
+
+// how build_model chooses the binning function of each split
+struct binning_config
 {
-    const func* m_func;
+    // if nonzero, binning functions are first evaluated on a stratified
+    // sample of this many rows of each bin, and rebuilt without being
+    // evaluated on the rest if they do not split it. the sample doubles
+    // with each rebuild, and a split is always made on the whole bin.
+    size_t m_sample_size = 0;
+
+    // the binning functions built for each split, which are evaluated
+    // together in one pass over the bin. the one whose bins are purest
+    // is kept, by information gain, rather than the first to split.
+    size_t m_candidate_count = 1;
+
+    // a bin is left as a leaf of its majority label, rather than split,
+    // once that label holds this fraction of its data points, once it
+    // holds fewer data points than m_min_split_size, or once it lies
+    // m_max_depth splits deep. by default only pure bins are leaves.
+    double m_leaf_purity = 1;
+    size_t m_min_split_size = 0;
+    size_t m_max_depth = std::numeric_limits<size_t>::max();
 };
-struct terminate
+
+struct search_config
 {
+    size_t m_iterations = std::numeric_limits<size_t>::max();
+    size_t m_recursion_limit;
+    double m_exploration_constant;
+    uint32_t m_seed = 27;
+
+    // if nonzero, binning functions are enumerated up to this
+    // size instead of being searched for
+    size_t m_enumeration_size = 0;
+
+    reward_mode m_reward_mode = reward_mode::node_count;
+
+    // the search stops at the first of the iteration count, the
+    // deadline, the target reward and a stop request
+    std::chrono::steady_clock::time_point m_deadline =
+        std::chrono::steady_clock::time_point::max();
+    double m_target_reward = std::numeric_limits<double>::infinity();
+    std::stop_token m_stop_token;
+
+    // once the tree has this many nodes, its least visited subtrees
+    // are evicted to make room for new ones
+    size_t m_max_tree_nodes = std::numeric_limits<size_t>::max();
+
+    // if true, rollouts reaching states equivalent to ones already in
+    // the tree share their statistics
+    bool m_use_transpositions = true;
+
+    // if true, rows of equal params and labels are binned once, and
+    // rows of equal params but different labels are rejected up front
+    bool m_collapse_duplicates = true;
+
+    binning_config m_binning;
+
+    // the reward lost for each training data point the model
+    // misclassifies, which only impure leaves do
+    double m_error_penalty = 1;
+
+    // called whenever the best model improves
+    std::function<void(const double&, const program&, const model&)>
+        m_on_improvement;
+
+    // if set, the search resumes from the checkpoint at this path if
+    // there is one, and saves one there every interval and on stopping
+    std::string m_checkpoint_path;
+    std::chrono::steady_clock::duration m_checkpoint_interval =
+        std::chrono::minutes(5);
 };
-struct make_function
+
+// thrown when a rollout can no longer beat the reward bound
+struct pruned_rollout
 {
+    // an upper bound on the reward the rollout could have had
+    double m_reward;
 };
 
-using choice =
-    std::variant<place_func_node, place_param_node, terminate, make_function>;
+////////////////////////////////////////////////////
+//////////////// FUNCTION GENERATION ///////////////
+////////////////////////////////////////////////////
+
+// build a body in pre-order, choosing each node through the rollout.
+// the args of commutative and associative funcs are only generated in
+// canonical order.
+func::body
+build_function(program& a_program, scope& a_scope,
+               std::multimap<std::type_index, size_t>& a_param_types,
+               std::stringstream& a_repr_stream,
+               const std::type_index& a_return_type,
+               const bool& a_allow_adding_params,
+               rollout<choice, std::mt19937>& a_rollout,
+               const size_t& a_recursion_limit);
+
+model build_model(
+    program& a_program, scope& a_scope,
+    std::multimap<std::type_index, size_t>& a_param_types,
+    const data_view& a_data, rollout<choice, std::mt19937>& a_rollout,
+    const size_t& a_recursion_limit,
+    const double& a_reward_bound = -std::numeric_limits<double>::infinity(),
+    search_stats* a_stats = nullptr, trace* a_trace = nullptr,
+    const binning_config& a_binning = {});
+
+// build a model of only the given rows of the data. a_weights holds the
+// number of data points each row stands for, by row index, or is empty
+// if each stands for itself.
+model build_model(
+    program& a_program, scope& a_scope,
+    std::multimap<std::type_index, size_t>& a_param_types,
+    const data_view& a_data, const std::vector<size_t>& a_rows,
+    const std::vector<size_t>& a_weights,
+    rollout<choice, std::mt19937>& a_rollout, const size_t& a_recursion_limit,
+    const double& a_reward_bound = -std::numeric_limits<double>::infinity(),
+    search_stats* a_stats = nullptr, trace* a_trace = nullptr,
+    const binning_config& a_binning = {});
+
+double model_reward(const program& a_program, const model& a_model);
+
+// the mean cost of evaluating the model on the data points, which
+// weights the cost of each path by the fraction of rows taking it
+double inference_cost(const model& a_model, const data_view& a_data);
+
+// the reward of a model under the given mode, less the penalty for each
+// data point it misclassifies
+double model_reward(const program& a_program, const model& a_model,
+                    const data_view& a_data, const reward_mode& a_mode,
+                    const double& a_error_penalty = 1);
+
+// measure the cost of each primitive in the scope, by profiling random
+// binning functions on the data, and declare it relative to the
+// cheapest primitive called
+void calibrate_costs(
+    program& a_program, scope& a_scope,
+    std::multimap<std::type_index, size_t> a_param_types,
+    const data_view& a_data, const size_t& a_function_count,
+    const size_t& a_recursion_limit, const uint32_t& a_seed = 27);
+
+// writes an improved model to stdout
+void print_improvement(const double& a_reward, const program& a_program,
+                       const model& a_model);
+
+// an anytime search, which returns the best model found whenever it
+// stops. the program and scope are left as those of the best model.
+template <typename... Params>
+model learn_model(
+    program& a_program, scope& a_scope, const data_view& a_data,
+    const search_config& a_config,
+    const std::shared_ptr<func>& a_baseline = nullptr,
+    incumbent* a_incumbent = nullptr, search_stats* a_stats = nullptr,
+    trace* a_trace = nullptr)
+{
+    // the state of the search, which is saved in checkpoints
+    search_state l_state{
+        .m_rnd_gen = std::mt19937(a_config.m_seed),
+        .m_tree = search_tree<choice>(a_config.m_max_tree_nodes),
+    };
+    l_state.m_tree.m_use_transpositions = a_config.m_use_transpositions;
+
+    // get the parameter types
+    std::vector<std::type_index> l_param_types_list = {typeid(Params)...};
+
+    // convert the parameter types to a multimap
+    std::multimap<std::type_index, size_t> l_param_types;
+    for(size_t i = 0; i < l_param_types_list.size(); ++i)
+        l_param_types.emplace(l_param_types_list[i], i);
+
+    // save the original program and scope
+    program l_original_program = a_program;
+    scope l_original_scope = a_scope;
+
+    // continue a search which was stopped
+    bool l_resumed =
+        !a_config.m_checkpoint_path.empty() &&
+        load_checkpoint(a_config.m_checkpoint_path, l_state, a_program,
+                        a_scope, l_original_program, l_param_types);
+
+    // the best model is kept in the state, under these names
+    double& l_best_reward = l_state.m_best_reward;
+    model& l_best_model = l_state.m_best_model;
+
+    // REASON: portfolios take their result from the incumbent, so the
+    // checkpointed best must reach it even if the search never beats it
+    if(l_resumed && a_incumbent != nullptr &&
+       l_best_reward != -std::numeric_limits<double>::infinity())
+        a_incumbent->offer(l_best_reward, a_program, l_best_model);
+
+    // start from the baseline [a_baseline] ? {1} : {0}, which must
+    // perfectly separate the data (e.g. a minimized sum of products)
+    if(a_baseline != nullptr && !l_resumed)
+    {
+        a_program.m_funcs.push_back(a_baseline);
+
+        l_best_model = model{
+            .m_func = a_baseline.get(),
+            .m_negative_child =
+                std::make_shared<model>(model{.m_homogenous_value = false}),
+            .m_positive_child =
+                std::make_shared<model>(model{.m_homogenous_value = true}),
+        };
+
+        l_best_reward = model_reward(a_program, l_best_model, a_data,
+                                     a_config.m_reward_mode,
+                                     a_config.m_error_penalty);
+
+        if(a_incumbent != nullptr)
+            a_incumbent->offer(l_best_reward, a_program, l_best_model);
+
+        if(a_config.m_on_improvement)
+            a_config.m_on_improvement(l_best_reward, a_program, l_best_model);
+    }
+
+    // the enumerative engine needs only a single pass
+    if(a_config.m_enumeration_size > 0)
+    {
+        program l_program = l_original_program;
+
+        // REASON: the enumerative engine tabulates terms on rows, so
+        // sources which store columns are converted
+        model l_model =
+            enumerate_model(l_program, a_scope, l_param_types, a_data.rows(),
+                            a_config.m_enumeration_size);
 
-// less than comparisons
-bool operator<(const place_func_node&, const place_func_node&);
-bool operator<(const place_param_node&, const place_param_node&);
-bool operator<(const terminate&, const terminate&);
-bool operator<(const make_function&, const make_function&);
+        double l_reward = model_reward(l_program, l_model, a_data,
+                                       a_config.m_reward_mode,
+                                       a_config.m_error_penalty);
+
+        if(a_incumbent != nullptr)
+            a_incumbent->offer(l_reward, l_program, l_model);
+
+        if(l_reward > l_best_reward)
+        {
+            a_program = l_program;
+            l_best_model = l_model;
+
+            if(a_config.m_on_improvement)
+                a_config.m_on_improvement(l_reward, l_program, l_model);
+        }
+
+        return l_best_model;
+    }
+
+    // the rows binning functions are evaluated on
+    // REASON: every function bins duplicates alike, so one of each is
+    // enough, and conflicts would leave a bin no function can split
+    std::vector<size_t> l_rows;
+
+    // the number of data points each row stands for, if collapsed
+    std::vector<size_t> l_weights;
+
+    if(a_config.m_collapse_duplicates)
+    {
+        unique_rows l_unique = collapse_duplicates(a_data);
+
+        // REASON: a bin of conflicts can only be left as an impure leaf
+        // once it is too deep to split
+        if(a_config.m_binning.m_max_depth ==
+           std::numeric_limits<size_t>::max())
+            check_conflicts(l_unique);
+
+        l_weights.resize(a_data.size());
+        for(size_t i = 0; i < l_unique.m_rows.size(); ++i)
+            l_weights[l_unique.m_rows[i]] = l_unique.m_weights[i];
+
+        l_rows = std::move(l_unique.m_rows);
+    }
+    else
+    {
+        l_rows.resize(a_data.size());
+        std::iota(l_rows.begin(), l_rows.end(), 0);
+    }
+
+    auto l_last_checkpoint = std::chrono::steady_clock::now();
+
+    for(; l_state.m_iteration < a_config.m_iterations; ++l_state.m_iteration)
+    {
+        // stop once the shared incumbent says so
+        if(a_incumbent != nullptr && a_incumbent->should_stop())
+            break;
+
+        auto l_now = std::chrono::steady_clock::now();
+
+        // REASON: stopping is cooperative, and only happens between
+        // rollouts, so the best model is always complete
+        if(a_config.m_stop_token.stop_requested() ||
+           l_best_reward >= a_config.m_target_reward ||
+           l_now >= a_config.m_deadline)
+            break;
+
+        // REASON: saved before the rollout draws from the generator, so
+        // that a resumed search repeats this iteration exactly
+        if(!a_config.m_checkpoint_path.empty() &&
+           l_now - l_last_checkpoint >= a_config.m_checkpoint_interval)
+        {
+            save_checkpoint(a_config.m_checkpoint_path, l_state, a_program,
+                            a_scope, l_original_program);
+            l_last_checkpoint = l_now;
+        }
+
+        // rollouts which cannot beat the shared incumbent are pruned
+        // REASON: build_model bounds the node count, which says nothing
+        // about the inference cost
+        double l_reward_bound =
+            a_incumbent != nullptr &&
+                    a_config.m_reward_mode == reward_mode::node_count
+                ? a_incumbent->m_reward.load()
+                : -std::numeric_limits<double>::infinity();
+
+        if(a_stats != nullptr)
+        {
+            ++a_stats->m_iterations;
+
+            if(a_stats->m_report && a_stats->m_report_interval > 0 &&
+               a_stats->m_iterations % a_stats->m_report_interval == 0)
+                a_stats->m_report(*a_stats);
+        }
+
+        scoped_timer l_rollout_timer(a_stats ? &a_stats->m_rollout_time
+                                             : nullptr);
+        trace_span l_span(a_trace, "iteration");
+        l_span.arg("index", l_state.m_iteration);
+
+        // construct the rollout
+        rollout<choice, std::mt19937> l_rollout(
+            l_state.m_tree, a_config.m_exploration_constant,
+            l_state.m_rnd_gen);
+
+        // restore the original program and scope
+        program l_program;
+        scope l_scope;
+        {
+            scoped_timer l_timer(a_stats ? &a_stats->m_program_copy_time
+                                         : nullptr);
+            l_program = l_original_program;
+            l_scope = l_original_scope;
+        }
+
+        model l_model;
+        double l_reward;
+
+        try
+        {
+            // construct the model
+            l_model = build_model(l_program, l_scope, l_param_types, a_data,
+                                  l_rows, l_weights, l_rollout,
+                                  a_config.m_recursion_limit, l_reward_bound,
+                                  a_stats, a_trace, a_config.m_binning);
+
+            // compute the reward (negative number of nodes, less the
+            // penalty for errors)
+            scoped_timer l_timer(a_stats ? &a_stats->m_node_count_time
+                                         : nullptr);
+            l_reward = model_reward(l_program, l_model, a_data,
+                                    a_config.m_reward_mode,
+                                    a_config.m_error_penalty);
+        }
+        catch(const pruned_rollout& a_pruned)
+        {
+            if(a_stats != nullptr)
+                ++a_stats->m_pruned_rollouts;
+
+            l_span.arg("pruned", 1);
+
+            l_rollout.terminate(a_pruned.m_reward);
+            continue;
+        }
+
+        if(a_stats != nullptr)
+            ++a_stats->m_model_depths[l_model.depth()];
+
+        l_span.arg("reward", l_reward);
+
+        // save best model
+        if(l_reward > l_best_reward)
+        {
+            l_best_reward = l_reward;
+            a_program = l_program;
+            a_scope = l_scope;
+            l_best_model = l_model;
+
+            if(a_incumbent != nullptr)
+                a_incumbent->offer(l_reward, l_program, l_model);
+
+            if(a_stats != nullptr)
+                ++a_stats->m_improvements;
+
+            if(a_config.m_on_improvement)
+                a_config.m_on_improvement(l_reward, l_program, l_model);
+        }
+
+        // terminate the rollout
+        l_rollout.terminate(l_reward);
+    }
+
+    if(!a_config.m_checkpoint_path.empty())
+        save_checkpoint(a_config.m_checkpoint_path, l_state, a_program,
+                        a_scope, l_original_program);
+
+    return l_best_model;
+}
+
+// learn from typed columns, whose types are those of the params
+template <typename... Params>
+model learn_model(program& a_program, scope& a_scope,
+                  const typed_dataset<Params...>& a_data,
+                  const search_config& a_config,
+                  const std::shared_ptr<func>& a_baseline = nullptr,
+                  incumbent* a_incumbent = nullptr,
+                  search_stats* a_stats = nullptr, trace* a_trace = nullptr)
+{
+    return learn_model<Params...>(a_program, a_scope, data_view(a_data),
+                                  a_config, a_baseline, a_incumbent, a_stats,
+                                  a_trace);
+}
+
+// learn from rows of typed params, which are split into columns first
+template <typename... Params>
+model learn_model(program& a_program, scope& a_scope,
+                  const std::vector<std::tuple<Params...>>& a_rows,
+                  const std::vector<bool>& a_labels,
+                  const search_config& a_config,
+                  const std::shared_ptr<func>& a_baseline = nullptr,
+                  incumbent* a_incumbent = nullptr,
+                  search_stats* a_stats = nullptr, trace* a_trace = nullptr)
+{
+    return learn_model(a_program, a_scope,
+                       make_typed_dataset(a_rows, a_labels), a_config,
+                       a_baseline, a_incumbent, a_stats, a_trace);
+}
+
+template <typename... Params>
+model learn_model(
+    program& a_program, scope& a_scope, const data_view& a_data,
+    const size_t& a_iterations, const size_t& a_recursion_limit,
+    const double& a_exploration_constant,
+    const std::shared_ptr<func>& a_baseline = nullptr)
+{
+    return learn_model<Params...>(
+        a_program, a_scope, a_data,
+        search_config{
+            .m_iterations = a_iterations,
+            .m_recursion_limit = a_recursion_limit,
+            .m_exploration_constant = a_exploration_constant,
+            .m_on_improvement = print_improvement,
+        },
+        a_baseline);
+}
 
 #endif
@@ -0,0 +1,101 @@
+#ifndef SEARCH_STATS_HPP
+#define SEARCH_STATS_HPP
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+
+// counts of how often each value occurred
+using histogram = std::map<size_t, size_t>;
+
+// counters, cumulative phase timers and distributions collected by
+// learn_model. collection is skipped entirely when no stats object is
+// given, so a disabled search pays only for null checks.
+struct search_stats
+{
+    ////////////////////////////////////////////////////
+    ///////////////////// COUNTERS /////////////////////
+    ////////////////////////////////////////////////////
+    size_t m_iterations = 0;
+    size_t m_pruned_rollouts = 0;
+    size_t m_improvements = 0;
+
+    // binning functions which split the data, and those which were
+    // rebuilt because they left a bin empty
+    size_t m_binning_functions = 0;
+    size_t m_binning_retries = 0;
+
+    // binning functions rebuilt because they did not split the sample
+    // of a bin, without being evaluated on the rest
+    size_t m_sample_rejections = 0;
+
+    // bins left as leaves of their majority label while still impure
+    size_t m_impure_leaves = 0;
+
+    // evaluations of a binning function on a data point
+    size_t m_rows_evaluated = 0;
+
+    // splits after which a rollout continued from the node of an
+    // equivalent state
+    size_t m_transpositions = 0;
+
+    ////////////////////////////////////////////////////
+    ////////////////////// TIMERS //////////////////////
+    ////////////////////////////////////////////////////
+
+    // whole rollouts, including all of the phases below
+    std::chrono::steady_clock::duration m_rollout_time{};
+
+    // choosing binning function bodies
+    std::chrono::steady_clock::duration m_build_function_time{};
+
+    // evaluating binning functions into bins
+    std::chrono::steady_clock::duration m_bin_evaluation_time{};
+
+    // copying programs and scopes to restore them
+    std::chrono::steady_clock::duration m_program_copy_time{};
+
+    // counting nodes to compute rewards and bounds
+    std::chrono::steady_clock::duration m_node_count_time{};
+
+    ////////////////////////////////////////////////////
+    ////////////////// DISTRIBUTIONS ///////////////////
+    ////////////////////////////////////////////////////
+
+    // depth of each completed model
+    histogram m_model_depths;
+
+    // node count of each binning function which split the data
+    histogram m_binning_function_sizes;
+
+    // retries needed by each split
+    histogram m_retry_counts;
+
+    // data points binned by each split
+    histogram m_rows_per_split;
+
+    ////////////////////////////////////////////////////
+    ///////////////////// REPORTING ////////////////////
+    ////////////////////////////////////////////////////
+
+    // if set, called every m_report_interval iterations, or never if
+    // the interval is 0
+    std::function<void(const search_stats&)> m_report;
+    size_t m_report_interval = 1000;
+
+    // a human readable summary
+    std::string repr() const;
+};
+
+// adds the time it is alive to a timer, if there is one
+struct scoped_timer
+{
+    std::chrono::steady_clock::duration* m_timer;
+    std::chrono::steady_clock::time_point m_start;
+
+    scoped_timer(std::chrono::steady_clock::duration* a_timer);
+    ~scoped_timer();
+};
+
+#endif
@@ -0,0 +1,415 @@
+#ifndef SEARCH_TREE_HPP
+#define SEARCH_TREE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// fold a value into a state key
+inline uint64_t mix_key(const uint64_t& a_key, const uint64_t& a_value)
+{
+    // REASON: the splitmix64 finalizer, so that nearby values give
+    // unrelated keys
+    uint64_t l_key = a_key ^ (a_value + 0x9e3779b97f4a7c15 + (a_key << 6) +
+                              (a_key >> 2));
+    l_key = (l_key ^ (l_key >> 30)) * 0xbf58476d1ce4e5b9;
+    l_key = (l_key ^ (l_key >> 27)) * 0x94d049bb133111eb;
+    return l_key ^ (l_key >> 31);
+}
+
+// the statistics of every choice sequence explored by a monte carlo
+// tree search. nodes live in a pool of parallel arrays, and the children
+// of each node are listed in order of their choices. the tree grows by at
+// most one node per rollout, and once it holds m_max_nodes nodes, its least
+// visited subtrees are evicted to make room.
+template <typename CHOICE>
+struct search_tree
+{
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    // REASON: evicting half of the evictable nodes at a time keeps the
+    // cost of eviction constant per expansion
+    static constexpr double EVICTION_FRACTION = 0.5;
+
+    ////////////////////////////////////////////////////
+    //////////////////// NODE ARRAYS ///////////////////
+    ////////////////////////////////////////////////////
+
+    // the sum of the rewards of the rollouts through each node
+    std::vector<double> m_values;
+    std::vector<size_t> m_visits;
+
+    // the parent of each node, NONE for the root and free slots
+    std::vector<size_t> m_parents;
+
+    // REASON: sorted by choice, so that a rollout choosing among k
+    // choices finds their children in O(k log k) rather than O(k^2)
+    std::vector<std::vector<size_t>> m_children;
+
+    // the choice leading to each node from its parent
+    std::vector<CHOICE> m_choices;
+
+    // slots of evicted nodes, reused before the arrays grow
+    std::vector<size_t> m_free;
+
+    size_t m_max_nodes;
+
+    // the number of nodes evicted so far
+    size_t m_evicted = 0;
+
+    ////////////////////////////////////////////////////
+    //////////////// TRANSPOSITION TABLE ///////////////
+    ////////////////////////////////////////////////////
+
+    // if false, equivalent states keep separate nodes
+    bool m_use_transpositions = true;
+
+    // the node holding the statistics of each state key
+    std::unordered_map<uint64_t, size_t> m_transposition_table;
+
+    // the key each node was entered in the table under
+    std::vector<uint64_t> m_keys;
+
+    // normal constructor, the root is node 0
+    search_tree(
+        const size_t& a_max_nodes = std::numeric_limits<size_t>::max())
+        : m_max_nodes(std::max<size_t>(a_max_nodes, 1))
+    {
+        allocate(NONE, CHOICE{});
+    }
+
+    // the number of nodes in the tree
+    size_t size() const
+    {
+        return m_values.size() - m_free.size();
+    }
+
+    // the first child of the node whose choice is not before the given
+    // one
+    std::vector<size_t>::const_iterator
+    lower_bound(const size_t& a_node, const CHOICE& a_choice) const
+    {
+        return std::lower_bound(m_children[a_node].begin(),
+                                m_children[a_node].end(), a_choice,
+                                [this](size_t a_child, const CHOICE& a_value)
+                                { return m_choices[a_child] < a_value; });
+    }
+
+    // the child reached by the choice, NONE if it is not in the tree
+    size_t child(const size_t& a_node, const CHOICE& a_choice) const
+    {
+        auto l_child = lower_bound(a_node, a_choice);
+
+        if(l_child == m_children[a_node].end() ||
+           a_choice < m_choices[*l_child])
+            return NONE;
+
+        return *l_child;
+    }
+
+    // add a child reached by the choice, returns its index
+    size_t add_child(const size_t& a_node, const CHOICE& a_choice)
+    {
+        size_t l_child = allocate(a_node, a_choice);
+
+        link(l_child);
+
+        return l_child;
+    }
+
+    // evict the least visited subtrees, except for the given nodes and
+    // their ancestors. since the visits of a subtree are already counted
+    // in its parent, evicting it collapses it into the parent's
+    // statistics. returns false if nothing could be evicted.
+    bool evict(const std::vector<size_t>& a_protected)
+    {
+        std::vector<bool> l_protected(m_values.size(), false);
+        for(size_t l_node : a_protected)
+            for(; l_node != NONE && !l_protected[l_node];
+                l_node = m_parents[l_node])
+                l_protected[l_node] = true;
+
+        // find the visit count below which nodes are evicted
+        std::vector<size_t> l_candidate_visits;
+        for(size_t i = 0; i < m_values.size(); ++i)
+            if(is_live(i) && !l_protected[i])
+                l_candidate_visits.push_back(m_visits[i]);
+
+        if(l_candidate_visits.empty())
+            return false;
+
+        auto l_threshold_it =
+            l_candidate_visits.begin() +
+            size_t(EVICTION_FRACTION * (l_candidate_visits.size() - 1));
+        std::nth_element(l_candidate_visits.begin(), l_threshold_it,
+                         l_candidate_visits.end());
+        size_t l_threshold = *l_threshold_it;
+
+        // REASON: collected first, since evicting a subtree frees nodes
+        // which would otherwise be visited later in this loop
+        std::vector<size_t> l_roots;
+        for(size_t i = 0; i < m_values.size(); ++i)
+            if(is_live(i) && !l_protected[i] && m_visits[i] <= l_threshold &&
+               (l_protected[m_parents[i]] ||
+                m_visits[m_parents[i]] > l_threshold))
+                l_roots.push_back(i);
+
+        for(size_t l_root : l_roots)
+        {
+            unlink(l_root);
+            release(l_root);
+        }
+
+        return true;
+    }
+
+    // true if the slot holds a node
+    bool is_live(const size_t& a_node) const
+    {
+        return a_node == 0 || m_parents[a_node] != NONE;
+    }
+
+    // take a slot from the pool, or grow the arrays
+    size_t allocate(const size_t& a_parent, const CHOICE& a_choice)
+    {
+        size_t l_node = m_values.size();
+
+        if(!m_free.empty())
+        {
+            l_node = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            m_values.emplace_back();
+            m_visits.emplace_back();
+            m_parents.emplace_back();
+            m_children.emplace_back();
+            m_choices.emplace_back();
+            m_keys.emplace_back();
+        }
+
+        m_values[l_node] = 0;
+        m_visits[l_node] = 0;
+        m_parents[l_node] = a_parent;
+        m_children[l_node].clear();
+        m_choices[l_node] = a_choice;
+
+        return l_node;
+    }
+
+    // add a node to its parent's children, in order of its choice
+    void link(const size_t& a_node)
+    {
+        m_children[m_parents[a_node]].insert(
+            lower_bound(m_parents[a_node], m_choices[a_node]), a_node);
+    }
+
+    // remove a node from its parent's children
+    void unlink(const size_t& a_node)
+    {
+        m_children[m_parents[a_node]].erase(
+            lower_bound(m_parents[a_node], m_choices[a_node]));
+    }
+
+    // return a node and its descendants to the pool
+    void release(const size_t& a_node)
+    {
+        for(size_t l_child : m_children[a_node])
+            release(l_child);
+
+        m_children[a_node].clear();
+
+        // forget the node's state key
+        auto l_entry = m_transposition_table.find(m_keys[a_node]);
+        if(l_entry != m_transposition_table.end() && l_entry->second == a_node)
+            m_transposition_table.erase(l_entry);
+
+        m_parents[a_node] = NONE;
+        m_free.push_back(a_node);
+        ++m_evicted;
+    }
+};
+
+// a single descent through a search tree. while in the tree, choices
+// are made by UCT. the first unexplored choice is added to the tree if
+// there is room, and every choice after it is uniformly random. states
+// which the caller knows to be equivalent share a node, through
+// transpose.
+//
+// this replaced the mcts submodule, and a seed does not reproduce the
+// models the submodule found: UCT here takes the log of the parent's
+// visits rather than of one more than them, the choice expanded is
+// drawn at random from the unexplored ones rather than taken in the
+// submodule's order, and ?0 and ?1 are distinct choices, since
+// place_param_node now orders by index.
+template <typename CHOICE, typename RND_GEN>
+struct rollout
+{
+    search_tree<CHOICE>& m_tree;
+    double m_exploration_constant;
+    RND_GEN& m_rnd_gen;
+
+    // indices of the nodes descended through, starting at the root
+    std::vector<size_t> m_path;
+
+    // true while the last node of the path is the current state
+    bool m_in_tree = true;
+
+    // true once this rollout has added a node
+    bool m_expanded = false;
+
+    // the key of the last state passed to transpose
+    uint64_t m_state_key = 0;
+
+    // normal constructor
+    rollout(search_tree<CHOICE>& a_tree, const double& a_exploration_constant,
+            RND_GEN& a_rnd_gen)
+        : m_tree(a_tree), m_exploration_constant(a_exploration_constant),
+          m_rnd_gen(a_rnd_gen), m_path{0}
+    {
+    }
+
+    // pick one of the choices
+    CHOICE choose(const std::vector<CHOICE>& a_choices)
+    {
+        if(!m_in_tree || m_expanded)
+        {
+            m_in_tree = false;
+            return random_choice(a_choices);
+        }
+
+        size_t l_current = m_path.back();
+
+        // find the child of each choice
+        std::vector<size_t> l_children(a_choices.size());
+        std::vector<CHOICE> l_unexplored;
+
+        for(size_t i = 0; i < a_choices.size(); ++i)
+        {
+            l_children[i] = m_tree.child(l_current, a_choices[i]);
+
+            if(l_children[i] == search_tree<CHOICE>::NONE)
+                l_unexplored.push_back(a_choices[i]);
+        }
+
+        ////////////////////////////////////////////////////
+        //////////////// EXPAND IF POSSIBLE ////////////////
+        ////////////////////////////////////////////////////
+        if(!l_unexplored.empty())
+        {
+            CHOICE l_choice = random_choice(l_unexplored);
+
+            // make room by evicting cold subtrees, but never this path
+            if(m_tree.size() >= m_tree.m_max_nodes)
+                m_tree.evict(m_path);
+
+            if(m_tree.size() < m_tree.m_max_nodes)
+            {
+                m_path.push_back(m_tree.add_child(l_current, l_choice));
+                m_expanded = true;
+            }
+            else
+            {
+                m_in_tree = false;
+            }
+
+            return l_choice;
+        }
+
+        ////////////////////////////////////////////////////
+        //////////////////// SELECT BY UCT /////////////////
+        ////////////////////////////////////////////////////
+        double l_log_visits =
+            std::log(std::max<size_t>(m_tree.m_visits[l_current], 1));
+
+        size_t l_best = 0;
+        double l_best_score = -std::numeric_limits<double>::infinity();
+
+        for(size_t i = 0; i < a_choices.size(); ++i)
+        {
+            double l_value = m_tree.m_values[l_children[i]];
+            size_t l_visits = m_tree.m_visits[l_children[i]];
+
+            // REASON: a child with no visits is one whose rollout did
+            // not finish, so it is worth retrying
+            double l_score =
+                l_visits == 0
+                    ? std::numeric_limits<double>::infinity()
+                    : l_value / l_visits + m_exploration_constant *
+                                               std::sqrt(l_log_visits /
+                                                         l_visits);
+
+            if(i == 0 || l_score > l_best_score)
+            {
+                l_best = i;
+                l_best_score = l_score;
+            }
+        }
+
+        m_path.push_back(l_children[l_best]);
+
+        return a_choices[l_best];
+    }
+
+    // declare that the current state has the given key. if a state with
+    // the same key already has a node, the rollout continues from that
+    // node, even if it had left the tree. otherwise the current node, if
+    // there is one, becomes the node of the key. returns true if the
+    // rollout moved.
+    bool transpose(const uint64_t& a_key)
+    {
+        m_state_key = a_key;
+
+        if(!m_tree.m_use_transpositions)
+            return false;
+
+        size_t l_current =
+            m_in_tree ? m_path.back() : search_tree<CHOICE>::NONE;
+
+        auto l_entry = m_tree.m_transposition_table.find(a_key);
+
+        if(l_entry == m_tree.m_transposition_table.end())
+        {
+            if(l_current != search_tree<CHOICE>::NONE)
+            {
+                m_tree.m_transposition_table.emplace(a_key, l_current);
+                m_tree.m_keys[l_current] = a_key;
+            }
+
+            return false;
+        }
+
+        if(l_entry->second == l_current)
+            return false;
+
+        m_path.push_back(l_entry->second);
+        m_in_tree = true;
+
+        return true;
+    }
+
+    // credit the reward to every node descended through
+    void terminate(const double& a_reward)
+    {
+        for(size_t l_node : m_path)
+        {
+            ++m_tree.m_visits[l_node];
+            m_tree.m_values[l_node] += a_reward;
+        }
+    }
+
+    // pick one of the choices uniformly at random
+    CHOICE random_choice(const std::vector<CHOICE>& a_choices)
+    {
+        std::uniform_int_distribution<size_t> l_distribution(
+            0, a_choices.size() - 1);
+        return a_choices[l_distribution(m_rnd_gen)];
+    }
+};
+
+#endif
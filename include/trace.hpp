@@ -0,0 +1,66 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// a timeline of spans, written in the chrome trace event format so
+// that it can be opened in a trace viewer (e.g. perfetto)
+struct trace
+{
+    // a completed span
+    struct event
+    {
+        const char* m_name;
+        std::chrono::steady_clock::time_point m_start;
+        std::chrono::steady_clock::duration m_duration;
+        size_t m_thread;
+        std::map<std::string, double> m_args;
+    };
+
+    // timestamps are relative to the creation of the trace
+    std::chrono::steady_clock::time_point m_origin;
+
+    // guards the events and thread numbers
+    std::mutex m_mutex;
+
+    std::vector<event> m_events;
+
+    // threads are numbered in the order they first record
+    std::map<std::thread::id, size_t> m_threads;
+
+    // normal constructor
+    trace();
+
+    // add a span recorded by the calling thread
+    void record(const char* a_name,
+                const std::chrono::steady_clock::time_point& a_start,
+                const std::chrono::steady_clock::time_point& a_end,
+                const std::map<std::string, double>& a_args);
+
+    // write the spans as a chrome trace json document
+    void write(std::ostream& a_stream);
+};
+
+// records a span from its construction to its destruction, if there is
+// a trace
+struct trace_span
+{
+    trace* m_trace;
+    const char* m_name;
+    std::chrono::steady_clock::time_point m_start;
+    std::map<std::string, double> m_args;
+
+    trace_span(trace* a_trace, const char* a_name);
+    ~trace_span();
+
+    // attach a value to the span
+    void arg(const std::string& a_key, const double& a_value);
+};
+
+#endif
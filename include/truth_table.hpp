@@ -0,0 +1,38 @@
+#ifndef TRUTH_TABLE_HPP
+#define TRUTH_TABLE_HPP
+
+#include "model.hpp"
+#include <any>
+#include <cstdint>
+#include <vector>
+
+// a model over bool inputs, compiled into a packed lookup table
+struct truth_table
+{
+    // the largest number of inputs that may be tabulated
+    static constexpr size_t MAX_INPUT_COUNT = 24;
+
+    // the number of bool inputs
+    size_t m_input_count;
+
+    // one output bit per input combination, indexed by key
+    std::vector<uint64_t> m_bits;
+
+    // tabulate the model by evaluating it on all 2^n inputs
+    truth_table(const model& a_model, size_t a_input_count);
+
+    // pack bool params into a key (param i is bit i)
+    static uint64_t key(const std::any* a_params, size_t a_param_count);
+
+    // look up the output for a key
+    bool eval(uint64_t a_key) const;
+
+    // look up the output for bool params
+    bool eval(const std::any* a_params, size_t a_param_count) const;
+
+    // look up the outputs for a batch of keys
+    void eval(const uint64_t* a_keys, size_t a_key_count,
+              bool* a_results) const;
+};
+
+#endif
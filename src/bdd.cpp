@@ -0,0 +1,504 @@
+#include "../include/bdd.hpp"
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+
+bdd::bdd(const std::vector<size_t>& a_order)
+    : m_order(a_order), m_levels(a_order.size())
+{
+    // record the level of each variable
+    for(size_t i = 0; i < m_order.size(); ++i)
+        m_levels.at(m_order[i]) = i;
+
+    // the terminals branch on a variable past the last level
+    m_nodes.push_back(node{m_order.size(), FALSE_NODE, FALSE_NODE});
+    m_nodes.push_back(node{m_order.size(), TRUE_NODE, TRUE_NODE});
+}
+
+size_t bdd::make_node(size_t a_var, size_t a_low, size_t a_high)
+{
+    // REASON: a decision with equal branches is redundant
+    if(a_low == a_high)
+        return a_low;
+
+    // share an existing node if there is one
+    auto l_key = std::make_tuple(a_var, a_low, a_high);
+    auto l_it = m_unique_table.find(l_key);
+    if(l_it != m_unique_table.end())
+        return l_it->second;
+
+    // otherwise, create the node
+    m_nodes.push_back(node{a_var, a_low, a_high});
+    m_unique_table.emplace(l_key, m_nodes.size() - 1);
+
+    return m_nodes.size() - 1;
+}
+
+size_t bdd::var(size_t a_var)
+{
+    if(a_var >= m_order.size())
+        throw std::runtime_error("Error: variable not in bdd order.");
+
+    return make_node(a_var, FALSE_NODE, TRUE_NODE);
+}
+
+size_t bdd::ite(size_t a_f, size_t a_g, size_t a_h)
+{
+    ////////////////////////////////////////////////////
+    //////////////// CHECK FOR TRIVIALITY //////////////
+    ////////////////////////////////////////////////////
+    if(a_f == TRUE_NODE)
+        return a_g;
+    if(a_f == FALSE_NODE)
+        return a_h;
+    if(a_g == a_h)
+        return a_g;
+    if(a_g == TRUE_NODE && a_h == FALSE_NODE)
+        return a_f;
+
+    ////////////////////////////////////////////////////
+    ////////////// CHECK THE COMPUTED TABLE ////////////
+    ////////////////////////////////////////////////////
+    auto l_key = std::make_tuple(a_f, a_g, a_h);
+    auto l_it = m_computed_table.find(l_key);
+    if(l_it != m_computed_table.end())
+        return l_it->second;
+
+    ////////////////////////////////////////////////////
+    /////////////// EXPAND ON THE TOP VAR //////////////
+    ////////////////////////////////////////////////////
+
+    // get the level of a node (terminals are below all variables)
+    auto l_level = [this](size_t a_node)
+    {
+        return a_node <= TRUE_NODE ? m_order.size()
+                                   : m_levels[m_nodes[a_node].m_var];
+    };
+
+    // the topmost variable of the three operands
+    size_t l_top_level =
+        std::min({l_level(a_f), l_level(a_g), l_level(a_h)});
+    size_t l_top_var = m_order[l_top_level];
+
+    // get the cofactor of a node w.r.t. the top variable
+    auto l_cofactor = [this, &l_level, l_top_level](size_t a_node,
+                                                    bool a_value)
+    {
+        if(l_level(a_node) != l_top_level)
+            return a_node;
+        return a_value ? m_nodes[a_node].m_high : m_nodes[a_node].m_low;
+    };
+
+    size_t l_low = ite(l_cofactor(a_f, false), l_cofactor(a_g, false),
+                       l_cofactor(a_h, false));
+    size_t l_high = ite(l_cofactor(a_f, true), l_cofactor(a_g, true),
+                        l_cofactor(a_h, true));
+
+    size_t l_result = make_node(l_top_var, l_low, l_high);
+
+    m_computed_table.emplace(l_key, l_result);
+
+    return l_result;
+}
+
+size_t bdd::negate(size_t a_f)
+{
+    return ite(a_f, FALSE_NODE, TRUE_NODE);
+}
+
+// collect the params referenced directly by a body
+void collect_support(const func::body& a_body, std::set<size_t>& a_support)
+{
+    if(const auto* l_param = std::get_if<func::param>(&a_body.m_functor))
+        a_support.insert(l_param->m_index);
+
+    for(const auto& l_child : a_body.m_children)
+        collect_support(l_child, a_support);
+}
+
+// shannon-expand a body over its support variables
+size_t expand(bdd& a_bdd, const func::body& a_body,
+              const std::vector<size_t>& a_support, size_t a_depth,
+              std::vector<std::any>& a_input)
+{
+    // all support variables are assigned, so evaluate
+    if(a_depth == a_support.size())
+        return std::any_cast<bool>(a_body.eval(a_input.data(), a_input.size()))
+                   ? bdd::TRUE_NODE
+                   : bdd::FALSE_NODE;
+
+    size_t l_var = a_support[a_depth];
+
+    a_input[l_var] = false;
+    size_t l_low = expand(a_bdd, a_body, a_support, a_depth + 1, a_input);
+
+    a_input[l_var] = true;
+    size_t l_high = expand(a_bdd, a_body, a_support, a_depth + 1, a_input);
+
+    return a_bdd.make_node(l_var, l_low, l_high);
+}
+
+size_t bdd::from_func(const func& a_func)
+{
+    // get the variables the body depends on
+    std::set<size_t> l_support_set;
+    collect_support(a_func.m_body, l_support_set);
+
+    // expand them in level order
+    std::vector<size_t> l_support(l_support_set.begin(), l_support_set.end());
+    std::sort(l_support.begin(), l_support.end(),
+              [this](size_t a_lhs, size_t a_rhs)
+              { return m_levels.at(a_lhs) < m_levels.at(a_rhs); });
+
+    // unused params are left as false
+    std::vector<std::any> l_input(m_order.size(), false);
+
+    return expand(*this, a_func.m_body, l_support, 0, l_input);
+}
+
+size_t bdd::from_model(const model& a_model)
+{
+    // if the model is homogenous, it is a terminal
+    if(a_model.m_func == nullptr)
+        return a_model.m_homogenous_value ? TRUE_NODE : FALSE_NODE;
+
+    return ite(from_func(*a_model.m_func),
+               from_model(*a_model.m_positive_child),
+               from_model(*a_model.m_negative_child));
+}
+
+// rebuild a node into another diagram, sharing rebuilt nodes
+size_t transfer_node(const bdd& a_source, size_t a_node, bdd& a_target,
+                     std::map<size_t, size_t>& a_transferred)
+{
+    if(a_node <= bdd::TRUE_NODE)
+        return a_node;
+
+    auto l_it = a_transferred.find(a_node);
+    if(l_it != a_transferred.end())
+        return l_it->second;
+
+    const bdd::node& l_node = a_source.m_nodes[a_node];
+
+    size_t l_result = a_target.ite(
+        a_target.var(l_node.m_var),
+        transfer_node(a_source, l_node.m_high, a_target, a_transferred),
+        transfer_node(a_source, l_node.m_low, a_target, a_transferred));
+
+    a_transferred.emplace(a_node, l_result);
+
+    return l_result;
+}
+
+size_t bdd::transfer(size_t a_root, bdd& a_target) const
+{
+    std::map<size_t, size_t> l_transferred;
+    return transfer_node(*this, a_root, a_target, l_transferred);
+}
+
+bool bdd::eval(size_t a_root, const std::any* a_params,
+               size_t a_param_count) const
+{
+    size_t l_node = a_root;
+
+    // follow the branches down to a terminal
+    while(l_node > TRUE_NODE)
+    {
+        const node& l_decision = m_nodes[l_node];
+
+        if(l_decision.m_var >= a_param_count)
+            throw std::runtime_error("Error: too few params for bdd.");
+
+        l_node = std::any_cast<bool>(a_params[l_decision.m_var])
+                     ? l_decision.m_high
+                     : l_decision.m_low;
+    }
+
+    return l_node == TRUE_NODE;
+}
+
+size_t bdd::size(size_t a_root) const
+{
+    std::set<size_t> l_visited;
+    std::vector<size_t> l_stack{a_root};
+
+    while(!l_stack.empty())
+    {
+        size_t l_node = l_stack.back();
+        l_stack.pop_back();
+
+        // skip terminals and already-counted nodes
+        if(l_node <= TRUE_NODE || !l_visited.insert(l_node).second)
+            continue;
+
+        l_stack.push_back(m_nodes[l_node].m_low);
+        l_stack.push_back(m_nodes[l_node].m_high);
+    }
+
+    return l_visited.size();
+}
+
+std::vector<size_t> natural_order(size_t a_var_count)
+{
+    std::vector<size_t> l_order(a_var_count);
+    std::iota(l_order.begin(), l_order.end(), 0);
+    return l_order;
+}
+
+// append the model's variables in preorder of first use
+void collect_first_use(const model& a_model, std::vector<size_t>& a_order)
+{
+    if(a_model.m_func == nullptr)
+        return;
+
+    std::vector<const func::body*> l_stack{&a_model.m_func->m_body};
+
+    while(!l_stack.empty())
+    {
+        const func::body* l_body = l_stack.back();
+        l_stack.pop_back();
+
+        if(const auto* l_param = std::get_if<func::param>(&l_body->m_functor))
+            if(std::find(a_order.begin(), a_order.end(),
+                         l_param->m_index) == a_order.end())
+                a_order.push_back(l_param->m_index);
+
+        // push in reverse so that the leftmost child is visited first
+        for(auto l_it = l_body->m_children.rbegin();
+            l_it != l_body->m_children.rend(); ++l_it)
+            l_stack.push_back(&*l_it);
+    }
+
+    collect_first_use(*a_model.m_positive_child, a_order);
+    collect_first_use(*a_model.m_negative_child, a_order);
+}
+
+std::vector<size_t> first_use_order(const model& a_model, size_t a_var_count)
+{
+    std::vector<size_t> l_order;
+    collect_first_use(a_model, l_order);
+
+    // unused variables go last
+    for(size_t i = 0; i < a_var_count; ++i)
+        if(std::find(l_order.begin(), l_order.end(), i) == l_order.end())
+            l_order.push_back(i);
+
+    return l_order;
+}
+
+std::vector<size_t> sift(const bdd& a_bdd, size_t a_root)
+{
+    std::vector<size_t> l_best_order = a_bdd.m_order;
+    size_t l_best_size = a_bdd.size(a_root);
+
+    // sift each variable through every level, keeping the best
+    for(size_t l_var : a_bdd.m_order)
+    {
+        // remove the variable from the order
+        std::vector<size_t> l_remaining = l_best_order;
+        l_remaining.erase(
+            std::find(l_remaining.begin(), l_remaining.end(), l_var));
+
+        for(size_t l_level = 0; l_level <= l_remaining.size(); ++l_level)
+        {
+            // place the variable at this level
+            std::vector<size_t> l_order = l_remaining;
+            l_order.insert(l_order.begin() + l_level, l_var);
+
+            // rebuild under the new order
+            bdd l_candidate(l_order);
+            size_t l_size =
+                l_candidate.size(a_bdd.transfer(a_root, l_candidate));
+
+            if(l_size < l_best_size)
+            {
+                l_best_size = l_size;
+                l_best_order = l_order;
+            }
+        }
+    }
+
+    return l_best_order;
+}
+
+bool equivalent(const model& a_lhs, const model& a_rhs, size_t a_var_count)
+{
+    // REASON: in a shared diagram, equal functions have equal ids
+    bdd l_bdd(first_use_order(a_lhs, a_var_count));
+    return l_bdd.from_model(a_lhs) == l_bdd.from_model(a_rhs);
+}
+
+#ifdef UNIT_TEST
+
+#include "../include/program.hpp"
+#include "test_utils.hpp"
+
+void test_bdd_construction()
+{
+    bdd l_bdd({2, 0, 1});
+
+    // only the terminals exist
+    assert(l_bdd.m_nodes.size() == 2);
+    assert(l_bdd.m_levels == std::vector<size_t>({1, 2, 0}));
+    assert(l_bdd.size(bdd::FALSE_NODE) == 0);
+    assert(l_bdd.size(bdd::TRUE_NODE) == 0);
+
+    // variables outside of the order are rejected
+    assert_throws(l_bdd.var(3), std::runtime_error);
+}
+
+void test_bdd_ite()
+{
+    bdd l_bdd(natural_order(3));
+
+    size_t l_x = l_bdd.var(0);
+    size_t l_y = l_bdd.var(1);
+
+    // nodes are shared
+    assert(l_bdd.var(0) == l_x);
+
+    // x && y == y && x
+    size_t l_and = l_bdd.ite(l_x, l_y, bdd::FALSE_NODE);
+    assert(l_bdd.ite(l_y, l_x, bdd::FALSE_NODE) == l_and);
+    assert(l_bdd.size(l_and) == 2);
+
+    // !(x && y) == !x || !y
+    size_t l_nand = l_bdd.negate(l_and);
+    assert(l_bdd.ite(l_bdd.negate(l_x), bdd::TRUE_NODE, l_bdd.negate(l_y)) ==
+           l_nand);
+
+    // x || !x == true
+    assert(l_bdd.ite(l_x, bdd::TRUE_NODE, l_bdd.negate(l_x)) ==
+           bdd::TRUE_NODE);
+
+    // evaluate x && y
+    for(bool l_a : {false, true})
+        for(bool l_b : {false, true})
+        {
+            std::vector<std::any> l_input{l_a, l_b, false};
+            assert(l_bdd.eval(l_and, l_input.data(), l_input.size()) ==
+                   (l_a && l_b));
+        }
+
+    // a variable without a param is rejected
+    std::vector<std::any> l_short{true};
+    assert_throws(l_bdd.eval(l_and, l_short.data(), l_short.size()),
+                  std::runtime_error);
+}
+
+void test_bdd_from_model()
+{
+    program l_program;
+
+    // add the primitives
+    std::function l_exor =
+        std::function([](bool a_x, bool a_y) { return a_x != a_y; });
+    auto l_exor_func = l_program.add_primitive("exor", l_exor);
+
+    // construct a binning function exor(?0, exor(?1, ?2))
+    func l_bin(typeid(bool), {{typeid(bool), 0}, {typeid(bool), 1},
+                              {typeid(bool), 2}},
+               func::body{
+                   .m_functor = l_exor_func,
+                   .m_children =
+                       {
+                           func::body{.m_functor = func::param{0}},
+                           func::body{
+                               .m_functor = l_exor_func,
+                               .m_children =
+                                   {
+                                       func::body{.m_functor = func::param{1}},
+                                       func::body{.m_functor = func::param{2}},
+                                   },
+                           },
+                       },
+               },
+               "exor(?0,exor(?1,?2))");
+
+    // construct the model [bin] ? 1 : 0
+    model l_model{.m_func = &l_bin};
+    l_model.m_positive_child =
+        std::make_shared<model>(model{.m_homogenous_value = true});
+    l_model.m_negative_child =
+        std::make_shared<model>(model{.m_homogenous_value = false});
+
+    bdd l_bdd(natural_order(3));
+    size_t l_root = l_bdd.from_model(l_model);
+
+    // 3-way parity needs one node for ?0, two each for ?1 and ?2
+    assert(l_bdd.size(l_root) == 5);
+
+    // agrees with the model on all inputs
+    for(bool l_a : {false, true})
+        for(bool l_b : {false, true})
+            for(bool l_c : {false, true})
+            {
+                std::vector<std::any> l_input{l_a, l_b, l_c};
+                assert(l_bdd.eval(l_root, l_input.data(), l_input.size()) ==
+                       l_model.eval(l_input.data(), l_input.size()));
+            }
+
+    // the inverted model [bin] ? 0 : 1 is not equivalent
+    model l_inverted{.m_func = &l_bin};
+    l_inverted.m_positive_child = l_model.m_negative_child;
+    l_inverted.m_negative_child = l_model.m_positive_child;
+    assert(!equivalent(l_model, l_inverted, 3));
+
+    // but inverting it again, by swapping its children back, is
+    model l_double_inverted{.m_func = &l_bin};
+    l_double_inverted.m_positive_child = l_inverted.m_negative_child;
+    l_double_inverted.m_negative_child = l_inverted.m_positive_child;
+    assert(equivalent(l_model, l_double_inverted, 3));
+    assert(!equivalent(l_inverted, l_double_inverted, 3));
+
+    // as is a deeper model, [bin] ? ([bin] ? 1 : 0) : 0, whose inner
+    // node is the negation of the inverted model
+    model l_nested{.m_func = &l_bin};
+    l_nested.m_positive_child = std::make_shared<model>(l_double_inverted);
+    l_nested.m_negative_child = l_model.m_negative_child;
+    assert(equivalent(l_model, l_nested, 3));
+    assert(!equivalent(l_inverted, l_nested, 3));
+}
+
+void test_bdd_sift()
+{
+    // (?0 && ?3) || (?1 && ?4) || (?2 && ?5) is exponential in the
+    // natural order and linear when paired variables are adjacent
+    bdd l_bdd(natural_order(6));
+    size_t l_root = bdd::FALSE_NODE;
+    for(size_t i = 0; i < 3; ++i)
+        l_root = l_bdd.ite(l_bdd.ite(l_bdd.var(i), l_bdd.var(i + 3),
+                                     bdd::FALSE_NODE),
+                           bdd::TRUE_NODE, l_root);
+
+    size_t l_natural_size = l_bdd.size(l_root);
+
+    bdd l_sifted(sift(l_bdd, l_root));
+    size_t l_sifted_root = l_bdd.transfer(l_root, l_sifted);
+
+    assert(l_sifted.size(l_sifted_root) == 6);
+    assert(l_sifted.size(l_sifted_root) < l_natural_size);
+
+    // sifting preserves the function
+    for(size_t l_key = 0; l_key < 64; ++l_key)
+    {
+        std::vector<std::any> l_input;
+        for(size_t i = 0; i < 6; ++i)
+            l_input.push_back(bool((l_key >> i) & 1));
+        assert(l_bdd.eval(l_root, l_input.data(), l_input.size()) ==
+               l_sifted.eval(l_sifted_root, l_input.data(), l_input.size()));
+    }
+}
+
+void bdd_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_bdd_construction);
+    TEST(test_bdd_ite);
+    TEST(test_bdd_from_model);
+    TEST(test_bdd_sift);
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// REASON: progress goes to stderr, so that stdout is only json
+#define BENCH(void_fn)                                                 \
+    std::cerr << ">>>> BENCH STARTING: " << #void_fn << std::endl;     \
+    void_fn();
+
+// a single measurement
+struct bench_result
+{
+    std::string m_name;
+    std::map<std::string, double> m_params;
+    std::map<std::string, double> m_metrics;
+};
+
+// all measurements, in the order they were taken
+inline std::vector<bench_result>& bench_results()
+{
+    static std::vector<bench_result> l_results;
+    return l_results;
+}
+
+// start measuring the peak resident set size afresh, returning false
+// if the kernel does not allow it
+// REASON: the peak of getrusage never decreases, so it would report the
+// peak of the largest bench run so far rather than of this one
+inline bool reset_peak_rss()
+{
+    std::ofstream l_stream("/proc/self/clear_refs");
+    l_stream << "5";
+    l_stream.flush();
+    return bool(l_stream);
+}
+
+// the peak resident set size since the last reset, in kilobytes
+inline double peak_rss_kb()
+{
+    std::ifstream l_stream("/proc/self/status");
+
+    for(std::string l_line; std::getline(l_stream, l_line);)
+        if(l_line.rfind("VmHWM:", 0) == 0)
+            return std::stod(l_line.substr(6));
+
+    return 0;
+}
+
+// prevent the optimizer from discarding a value
+template <typename T>
+inline void do_not_optimize(const T& a_value)
+{
+    asm volatile("" : : "g"(&a_value) : "memory");
+}
+
+// time a callable, doubling the number of iterations until the run is
+// long enough to trust
+template <typename Fn>
+void bench(const std::string& a_name,
+           const std::map<std::string, double>& a_params, Fn&& a_fn)
+{
+    constexpr auto MIN_DURATION = std::chrono::milliseconds(100);
+    constexpr size_t MAX_ITERATIONS = size_t{1} << 30;
+
+    for(size_t l_iterations = 1;; l_iterations *= 2)
+    {
+        auto l_start = std::chrono::steady_clock::now();
+
+        for(size_t i = 0; i < l_iterations; ++i)
+            a_fn();
+
+        auto l_elapsed = std::chrono::steady_clock::now() - l_start;
+
+        if(l_elapsed < MIN_DURATION && l_iterations < MAX_ITERATIONS)
+            continue;
+
+        double l_ns =
+            std::chrono::duration<double, std::nano>(l_elapsed).count();
+
+        bench_results().push_back(bench_result{
+            .m_name = a_name,
+            .m_params = a_params,
+            .m_metrics =
+                {
+                    {"iterations", l_iterations},
+                    {"ns_per_iteration", l_ns / l_iterations},
+                },
+        });
+
+        return;
+    }
+}
+
+// write a map of numbers as a json object
+inline void write_json_object(std::ostream& a_stream,
+                              const std::map<std::string, double>& a_map)
+{
+    a_stream << "{";
+
+    for(auto l_it = a_map.begin(); l_it != a_map.end(); ++l_it)
+    {
+        if(l_it != a_map.begin())
+            a_stream << ",";
+        a_stream << "\"" << l_it->first << "\":" << l_it->second;
+    }
+
+    a_stream << "}";
+}
+
+// write all measurements as a json document
+inline void write_bench_results(std::ostream& a_stream)
+{
+    a_stream << "{\"benchmarks\":[";
+
+    for(size_t i = 0; i < bench_results().size(); ++i)
+    {
+        const bench_result& l_result = bench_results()[i];
+
+        if(i > 0)
+            a_stream << ",";
+
+        a_stream << "\n{\"name\":\"" << l_result.m_name << "\",\"params\":";
+        write_json_object(a_stream, l_result.m_params);
+        a_stream << ",\"metrics\":";
+        write_json_object(a_stream, l_result.m_metrics);
+        a_stream << "}";
+    }
+
+    a_stream << "\n]}" << std::endl;
+}
+
+#endif
@@ -0,0 +1,670 @@
+#include "../include/checkpoint.hpp"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+// REASON: written in text, so that a checkpoint survives a rebuild
+constexpr int CHECKPOINT_VERSION = 5;
+
+////////////////////////////////////////////////////
+////////////////////// WRITING /////////////////////
+////////////////////////////////////////////////////
+
+// strings are length prefixed, since reprs are chosen by the user
+void write_string(std::ostream& a_stream, const std::string& a_string)
+{
+    a_stream << a_string.size() << ":" << a_string;
+}
+
+void write_body(std::ostream& a_stream, const func::body& a_body)
+{
+    if(const auto* l_param = std::get_if<func::param>(&a_body.m_functor))
+        a_stream << "p " << l_param->m_index;
+    else if(const auto* l_func = std::get_if<const func*>(&a_body.m_functor))
+        write_string(a_stream << "f ", (*l_func)->m_repr);
+    else
+        throw std::runtime_error("Error: primitive bodies cannot be saved.");
+
+    a_stream << " " << a_body.m_children.size();
+
+    for(const func::body& l_child : a_body.m_children)
+        write_body(a_stream << " ", l_child);
+}
+
+void write_model(std::ostream& a_stream, const model& a_model,
+                 const std::map<const func*, size_t>& a_func_indices)
+{
+    if(a_model.m_func == nullptr)
+    {
+        a_stream << "l " << a_model.m_homogenous_value << " "
+                 << a_model.m_error_count;
+        return;
+    }
+
+    a_stream << "b " << a_func_indices.at(a_model.m_func) << " ";
+    write_model(a_stream, *a_model.m_negative_child, a_func_indices);
+    a_stream << " ";
+    write_model(a_stream, *a_model.m_positive_child, a_func_indices);
+}
+
+void write_choice(std::ostream& a_stream, const choice& a_choice)
+{
+    if(const auto* l_func_node = std::get_if<place_func_node>(&a_choice))
+        write_string(a_stream << "f ", l_func_node->m_func->m_repr);
+    else if(const auto* l_param_node = std::get_if<place_param_node>(&a_choice))
+        a_stream << "p " << l_param_node->m_index;
+    else if(std::holds_alternative<terminate>(a_choice))
+        a_stream << "t";
+    else
+        a_stream << "m";
+}
+
+void write_checkpoint(std::ostream& a_stream, const search_state& a_state,
+                      const program& a_best_program, const scope& a_best_scope,
+                      const program& a_original_program)
+{
+    // REASON: rewards must round trip exactly for the search to
+    // continue exactly
+    a_stream.precision(std::numeric_limits<double>::max_digits10);
+
+    a_stream << "checkpoint " << CHECKPOINT_VERSION << std::endl;
+    a_stream << "iteration " << a_state.m_iteration << std::endl;
+    a_stream << "rnd_gen " << a_state.m_rnd_gen << std::endl;
+
+    ////////////////////////////////////////////////////
+    ///////////////// WRITE THE BEST MODEL /////////////
+    ////////////////////////////////////////////////////
+    bool l_has_best =
+        a_state.m_best_reward != -std::numeric_limits<double>::infinity();
+
+    a_stream << "best " << l_has_best;
+    if(l_has_best)
+        a_stream << " " << a_state.m_best_reward;
+    a_stream << std::endl;
+
+    // the funcs added to the original program
+    size_t l_original_count = a_original_program.m_funcs.size();
+
+    a_stream << "funcs " << a_best_program.m_funcs.size() - l_original_count
+             << std::endl;
+
+    std::map<const func*, size_t> l_func_indices;
+
+    for(const auto& l_func : a_best_program.m_funcs)
+    {
+        size_t l_index = l_func_indices.size();
+        l_func_indices.emplace(l_func.get(), l_index);
+
+        if(l_index < l_original_count)
+            continue;
+
+        write_string(a_stream, l_func->m_repr);
+        a_stream << " ";
+        write_body(a_stream, l_func->m_body);
+        a_stream << std::endl;
+    }
+
+    a_stream << "model ";
+    if(l_has_best)
+        write_model(a_stream, a_state.m_best_model, l_func_indices);
+    a_stream << std::endl;
+
+    // the scope's funcs, by index in the best program
+    a_stream << "scope "
+             << a_best_scope.m_nullaries.size() +
+                    a_best_scope.m_non_nullaries.size();
+
+    for(const auto* l_funcs :
+        {&a_best_scope.m_nullaries, &a_best_scope.m_non_nullaries})
+        for(const auto& [l_type, l_func] : *l_funcs)
+        {
+            auto l_index = l_func_indices.find(l_func);
+
+            if(l_index == l_func_indices.end())
+                throw std::runtime_error(
+                    "Error: scope func \"" + l_func->m_repr +
+                    "\" is not in the program, so cannot be saved.");
+
+            a_stream << " " << l_index->second;
+        }
+
+    a_stream << std::endl;
+
+    ////////////////////////////////////////////////////
+    /////////////////// WRITE THE TREE /////////////////
+    ////////////////////////////////////////////////////
+    const search_tree<choice>& l_tree = a_state.m_tree;
+
+    // REASON: the pool is written slot by slot, free slots included, so
+    // that the resumed tree allocates exactly as the saved one would
+    a_stream << "tree " << l_tree.m_values.size() << " "
+             << l_tree.m_evicted << std::endl;
+
+    for(size_t i = 0; i < l_tree.m_values.size(); ++i)
+    {
+        // REASON: the children of each node are sorted by choice, so
+        // the parents and choices alone determine them
+        a_stream << l_tree.m_values[i] << " " << l_tree.m_visits[i] << " "
+                 << l_tree.m_parents[i];
+
+        // only nodes with a parent were reached by a choice
+        if(i != 0 && l_tree.is_live(i))
+            write_choice(a_stream << " ", l_tree.m_choices[i]);
+
+        a_stream << std::endl;
+    }
+
+    a_stream << "free " << l_tree.m_free.size();
+    for(size_t l_slot : l_tree.m_free)
+        a_stream << " " << l_slot;
+    a_stream << std::endl;
+
+    a_stream << "transpositions " << l_tree.m_transposition_table.size();
+    for(const auto& [l_key, l_node] : l_tree.m_transposition_table)
+        a_stream << " " << l_key << " " << l_node;
+    a_stream << std::endl;
+}
+
+////////////////////////////////////////////////////
+////////////////////// READING /////////////////////
+////////////////////////////////////////////////////
+
+// read a value, throwing if there is none
+template <typename T>
+T read_value(std::istream& a_stream)
+{
+    T l_value;
+
+    if(!(a_stream >> l_value))
+        throw std::runtime_error("Error: malformed checkpoint.");
+
+    return l_value;
+}
+
+// read a keyword, throwing if it is not the expected one
+void expect(std::istream& a_stream, const std::string& a_keyword)
+{
+    if(read_value<std::string>(a_stream) != a_keyword)
+        throw std::runtime_error("Error: malformed checkpoint.");
+}
+
+std::string read_string(std::istream& a_stream)
+{
+    size_t l_size = read_value<size_t>(a_stream);
+
+    if(a_stream.get() != ':')
+        throw std::runtime_error("Error: malformed checkpoint.");
+
+    std::string l_string(l_size, '\0');
+
+    if(!a_stream.read(l_string.data(), l_size))
+        throw std::runtime_error("Error: malformed checkpoint.");
+
+    return l_string;
+}
+
+const func* find_func(const std::map<std::string, const func*>& a_funcs,
+                      const std::string& a_repr)
+{
+    auto l_it = a_funcs.find(a_repr);
+
+    if(l_it == a_funcs.end())
+        throw std::runtime_error("Error: unknown func in checkpoint.");
+
+    return l_it->second;
+}
+
+func::body read_body(std::istream& a_stream,
+                     const std::map<std::string, const func*>& a_funcs)
+{
+    func::body l_body;
+
+    std::string l_kind = read_value<std::string>(a_stream);
+
+    if(l_kind == "p")
+        l_body.m_functor = func::param{read_value<size_t>(a_stream)};
+    else if(l_kind == "f")
+        l_body.m_functor = find_func(a_funcs, read_string(a_stream));
+    else
+        throw std::runtime_error("Error: malformed checkpoint.");
+
+    l_body.m_children.resize(read_value<size_t>(a_stream));
+
+    for(func::body& l_child : l_body.m_children)
+        l_child = read_body(a_stream, a_funcs);
+
+    return l_body;
+}
+
+model read_model(std::istream& a_stream,
+                 const std::vector<const func*>& a_funcs)
+{
+    std::string l_kind = read_value<std::string>(a_stream);
+
+    if(l_kind == "l")
+    {
+        bool l_value = read_value<bool>(a_stream);
+        return model{
+            .m_homogenous_value = l_value,
+            .m_error_count = read_value<size_t>(a_stream),
+        };
+    }
+
+    if(l_kind != "b")
+        throw std::runtime_error("Error: malformed checkpoint.");
+
+    size_t l_index = read_value<size_t>(a_stream);
+
+    if(l_index >= a_funcs.size())
+        throw std::runtime_error("Error: malformed checkpoint.");
+
+    model l_negative_child = read_model(a_stream, a_funcs);
+    model l_positive_child = read_model(a_stream, a_funcs);
+
+    return model{
+        .m_func = a_funcs[l_index],
+        .m_negative_child = std::make_shared<model>(l_negative_child),
+        .m_positive_child = std::make_shared<model>(l_positive_child),
+    };
+}
+
+choice read_choice(std::istream& a_stream,
+                   const std::map<std::string, const func*>& a_funcs)
+{
+    std::string l_kind = read_value<std::string>(a_stream);
+
+    if(l_kind == "f")
+        return place_func_node{find_func(a_funcs, read_string(a_stream))};
+    if(l_kind == "p")
+        return place_param_node{read_value<size_t>(a_stream)};
+    if(l_kind == "t")
+        return terminate{};
+    if(l_kind == "m")
+        return make_function{};
+
+    throw std::runtime_error("Error: malformed checkpoint.");
+}
+
+void read_checkpoint(
+    std::istream& a_stream, search_state& a_state, program& a_best_program,
+    scope& a_best_scope, const program& a_original_program,
+    const std::multimap<std::type_index, size_t>& a_param_types)
+{
+    expect(a_stream, "checkpoint");
+    if(read_value<int>(a_stream) != CHECKPOINT_VERSION)
+        throw std::runtime_error("Error: unsupported checkpoint version.");
+
+    expect(a_stream, "iteration");
+    a_state.m_iteration = read_value<size_t>(a_stream);
+
+    expect(a_stream, "rnd_gen");
+    if(!(a_stream >> a_state.m_rnd_gen))
+        throw std::runtime_error("Error: malformed checkpoint.");
+
+    ////////////////////////////////////////////////////
+    ///////////////// READ THE BEST MODEL //////////////
+    ////////////////////////////////////////////////////
+    expect(a_stream, "best");
+    bool l_has_best = read_value<bool>(a_stream);
+
+    a_state.m_best_reward = l_has_best
+                                ? read_value<double>(a_stream)
+                                : -std::numeric_limits<double>::infinity();
+
+    // funcs are found by repr, the first of a repr wins
+    std::map<std::string, const func*> l_funcs_by_repr;
+    for(const auto& l_func : a_original_program.m_funcs)
+        l_funcs_by_repr.emplace(l_func->m_repr, l_func.get());
+
+    a_best_program = a_original_program;
+
+    expect(a_stream, "funcs");
+    size_t l_added_count = read_value<size_t>(a_stream);
+
+    for(size_t i = 0; i < l_added_count; ++i)
+    {
+        std::string l_repr = read_string(a_stream);
+        func::body l_body = read_body(a_stream, l_funcs_by_repr);
+
+        a_best_program.m_funcs.push_back(std::make_shared<func>(
+            typeid(bool), a_param_types, l_body, l_repr));
+    }
+
+    std::vector<const func*> l_funcs_by_index;
+    for(const auto& l_func : a_best_program.m_funcs)
+        l_funcs_by_index.push_back(l_func.get());
+
+    expect(a_stream, "model");
+    a_state.m_best_model =
+        l_has_best ? read_model(a_stream, l_funcs_by_index) : model{};
+
+    // REASON: added in the order written, so that funcs of one return
+    // type are offered in the same order as before
+    expect(a_stream, "scope");
+    size_t l_scope_size = read_value<size_t>(a_stream);
+
+    a_best_scope = scope{};
+
+    for(size_t i = 0; i < l_scope_size; ++i)
+    {
+        size_t l_index = read_value<size_t>(a_stream);
+
+        if(l_index >= l_funcs_by_index.size())
+            throw std::runtime_error("Error: malformed checkpoint.");
+
+        a_best_scope.add_function(l_funcs_by_index[l_index]);
+    }
+
+    ////////////////////////////////////////////////////
+    /////////////////// READ THE TREE //////////////////
+    ////////////////////////////////////////////////////
+    search_tree<choice>& l_tree = a_state.m_tree;
+
+    expect(a_stream, "tree");
+    size_t l_slot_count = read_value<size_t>(a_stream);
+    l_tree.m_evicted = read_value<size_t>(a_stream);
+
+    if(l_slot_count == 0)
+        throw std::runtime_error("Error: malformed checkpoint.");
+
+    l_tree.m_values.resize(l_slot_count);
+    l_tree.m_visits.resize(l_slot_count);
+    l_tree.m_parents.resize(l_slot_count);
+    l_tree.m_children.assign(l_slot_count, {});
+    l_tree.m_choices.assign(l_slot_count, choice{});
+
+    // check that a link is to a slot, or to no node
+    auto l_check_link = [l_slot_count](size_t a_link)
+    {
+        if(a_link != search_tree<choice>::NONE && a_link >= l_slot_count)
+            throw std::runtime_error("Error: malformed checkpoint.");
+        return a_link;
+    };
+
+    for(size_t i = 0; i < l_slot_count; ++i)
+    {
+        l_tree.m_values[i] = read_value<double>(a_stream);
+        l_tree.m_visits[i] = read_value<size_t>(a_stream);
+        l_tree.m_parents[i] = l_check_link(read_value<size_t>(a_stream));
+
+        if(i != 0 && l_tree.is_live(i))
+            l_tree.m_choices[i] = read_choice(a_stream, l_funcs_by_repr);
+    }
+
+    for(size_t i = 1; i < l_slot_count; ++i)
+    {
+        if(!l_tree.is_live(i))
+            continue;
+
+        // the parent must be live, and hold no other child of the choice
+        if(!l_tree.is_live(l_tree.m_parents[i]) ||
+           l_tree.child(l_tree.m_parents[i], l_tree.m_choices[i]) !=
+               search_tree<choice>::NONE)
+            throw std::runtime_error("Error: malformed checkpoint.");
+
+        l_tree.link(i);
+    }
+
+    expect(a_stream, "free");
+    l_tree.m_free.resize(read_value<size_t>(a_stream));
+    for(size_t& l_slot : l_tree.m_free)
+        l_slot = l_check_link(read_value<size_t>(a_stream));
+
+    expect(a_stream, "transpositions");
+
+    l_tree.m_keys.assign(l_slot_count, 0);
+    l_tree.m_transposition_table.clear();
+
+    size_t l_key_count = read_value<size_t>(a_stream);
+    for(size_t i = 0; i < l_key_count; ++i)
+    {
+        uint64_t l_key = read_value<uint64_t>(a_stream);
+        size_t l_node = read_value<size_t>(a_stream);
+
+        if(l_node >= l_slot_count || !l_tree.is_live(l_node))
+            throw std::runtime_error("Error: malformed checkpoint.");
+
+        l_tree.m_keys[l_node] = l_key;
+        l_tree.m_transposition_table.emplace(l_key, l_node);
+    }
+}
+
+////////////////////////////////////////////////////
+/////////////////////// FILES //////////////////////
+////////////////////////////////////////////////////
+
+void save_checkpoint(const std::string& a_path, const search_state& a_state,
+                     const program& a_best_program, const scope& a_best_scope,
+                     const program& a_original_program)
+{
+    std::string l_temporary_path = a_path + ".tmp";
+
+    {
+        std::ofstream l_file(l_temporary_path);
+        write_checkpoint(l_file, a_state, a_best_program, a_best_scope,
+                         a_original_program);
+
+        if(!l_file.flush())
+            throw std::runtime_error("Error: failed to write checkpoint.");
+    }
+
+    // REASON: renaming is atomic, writing is not
+    if(std::rename(l_temporary_path.c_str(), a_path.c_str()) != 0)
+        throw std::runtime_error("Error: failed to write checkpoint.");
+}
+
+bool load_checkpoint(
+    const std::string& a_path, search_state& a_state, program& a_best_program,
+    scope& a_best_scope, const program& a_original_program,
+    const std::multimap<std::type_index, size_t>& a_param_types)
+{
+    std::ifstream l_file(a_path);
+
+    if(!l_file)
+        return false;
+
+    read_checkpoint(l_file, a_state, a_best_program, a_best_scope,
+                    a_original_program, a_param_types);
+
+    return true;
+}
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+#include <filesystem>
+#include <sstream>
+
+void test_checkpoint_round_trip()
+{
+    program l_program;
+
+    auto l_and = l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; }));
+    auto l_not = l_program.add_primitive(
+        "not", std::function([](bool a_x) { return !a_x; }));
+
+    std::multimap<std::type_index, size_t> l_param_types{
+        {typeid(bool), 0},
+        {typeid(bool), 1},
+    };
+
+    // a best program with a binning function, and( ?0, not(?1))
+    program l_best_program = l_program;
+    func::body l_body{
+        .m_functor = l_and,
+        .m_children =
+            {
+                func::body{.m_functor = func::param{0}},
+                func::body{
+                    .m_functor = l_not,
+                    .m_children = {func::body{.m_functor = func::param{1}}},
+                },
+            },
+    };
+    l_best_program.m_funcs.push_back(std::make_shared<func>(
+        typeid(bool), l_param_types, l_body, "and(?0,not(?1))"));
+
+    search_state l_state;
+    l_state.m_iteration = 42;
+    l_state.m_rnd_gen.discard(1000);
+    l_state.m_best_reward = -14;
+    l_state.m_best_model = model{
+        .m_func = l_best_program.m_funcs.back().get(),
+        .m_negative_child =
+            std::make_shared<model>(model{.m_homogenous_value = false}),
+        .m_positive_child = std::make_shared<model>(
+            model{.m_homogenous_value = true, .m_error_count = 2}),
+    };
+
+    // a small capped tree, with free slots and values which do not
+    // print exactly
+    l_state.m_tree = search_tree<choice>(6);
+    std::mt19937 l_rnd_gen(27);
+    std::vector<choice> l_choices{
+        place_func_node{l_and},
+        place_func_node{l_not},
+        place_param_node{0},
+        place_param_node{1},
+    };
+    for(size_t i = 0; i < 20; ++i)
+    {
+        rollout<choice, std::mt19937> l_rollout(l_state.m_tree, 1,
+                                                l_rnd_gen);
+        l_rollout.choose(l_choices);
+        l_rollout.transpose(i % 3);
+        l_rollout.choose(l_choices);
+        l_rollout.terminate(-1.0 / 3.0 * i);
+    }
+    assert(l_state.m_tree.m_evicted > 0);
+    assert(!l_state.m_tree.m_transposition_table.empty());
+
+    // a best scope holding the binning function, after the primitives
+    scope l_best_scope;
+    l_best_scope.add_function(l_not);
+    l_best_scope.add_function(l_and);
+    l_best_scope.add_function(l_best_program.m_funcs.back().get());
+
+    std::stringstream l_stream;
+    write_checkpoint(l_stream, l_state, l_best_program, l_best_scope,
+                     l_program);
+
+    search_state l_read_state;
+    program l_read_program;
+    scope l_read_scope;
+    l_read_scope.add_function(l_and);
+    read_checkpoint(l_stream, l_read_state, l_read_program, l_read_scope,
+                    l_program, l_param_types);
+
+    assert(l_read_state.m_iteration == 42);
+    assert(l_read_state.m_rnd_gen == l_state.m_rnd_gen);
+    assert(l_read_state.m_best_reward == -14);
+
+    // the primitives are shared, the binning function is rebuilt
+    assert(l_read_program.m_funcs.size() == 3);
+    assert(l_read_program.m_funcs.front().get() == l_and);
+    assert(l_read_program.m_funcs.back()->m_repr == "and(?0,not(?1))");
+    assert(l_read_program.m_funcs.back()->m_body.repr() == l_body.repr());
+
+    assert(l_read_state.m_best_model.m_func ==
+           l_read_program.m_funcs.back().get());
+    assert(l_read_state.m_best_model.repr() == l_state.m_best_model.repr());
+    assert(l_read_state.m_best_model.error_count() == 2);
+
+    // the scope is replaced, in order, with the rebuilt binning function
+    assert(l_read_scope.m_nullaries.empty());
+    assert(l_read_scope.m_non_nullaries ==
+           (std::multimap<std::type_index, const func*>{
+               {typeid(bool), l_not},
+               {typeid(bool), l_and},
+               {typeid(bool), l_read_program.m_funcs.back().get()},
+           }));
+
+    // the tree is identical
+    const search_tree<choice>& l_tree = l_state.m_tree;
+    const search_tree<choice>& l_read_tree = l_read_state.m_tree;
+
+    assert(l_read_tree.m_values == l_tree.m_values);
+    assert(l_read_tree.m_visits == l_tree.m_visits);
+    assert(l_read_tree.m_parents == l_tree.m_parents);
+    assert(l_read_tree.m_children == l_tree.m_children);
+    assert(l_read_tree.m_free == l_tree.m_free);
+    assert(l_read_tree.m_evicted == l_tree.m_evicted);
+    assert(l_read_tree.m_transposition_table == l_tree.m_transposition_table);
+
+    for(const auto& [l_key, l_node] : l_tree.m_transposition_table)
+        assert(l_read_tree.m_keys[l_node] == l_key);
+
+    for(size_t i = 1; i < l_tree.m_values.size(); ++i)
+        if(l_tree.is_live(i))
+            assert(!(l_read_tree.m_choices[i] < l_tree.m_choices[i]) &&
+                   !(l_tree.m_choices[i] < l_read_tree.m_choices[i]));
+}
+
+void test_checkpoint_errors()
+{
+    program l_program;
+    search_state l_state;
+    program l_read_program;
+    scope l_read_scope;
+
+    // not a checkpoint
+    {
+        std::stringstream l_stream("hello");
+        assert_throws(read_checkpoint(l_stream, l_state, l_read_program,
+                                      l_read_scope, l_program, {}),
+                      std::runtime_error);
+    }
+
+    // a func which is not in the program
+    {
+        program l_other_program;
+        l_other_program.add_primitive(
+            "other", std::function([](bool a_x) { return a_x; }));
+
+        search_state l_other_state;
+        rollout<choice, std::mt19937> l_rollout(l_other_state.m_tree, 1,
+                                                l_other_state.m_rnd_gen);
+        l_rollout.choose(
+            {place_func_node{l_other_program.m_funcs.front().get()}});
+        l_rollout.terminate(-1);
+
+        std::stringstream l_stream;
+        write_checkpoint(l_stream, l_other_state, l_other_program, {},
+                         l_other_program);
+
+        assert_throws(read_checkpoint(l_stream, l_state, l_read_program,
+                                      l_read_scope, l_program, {}),
+                      std::runtime_error);
+    }
+
+    // a scope func which is not in the program cannot be written
+    {
+        program l_other_program;
+        scope l_other_scope;
+        l_other_scope.add_function(l_other_program.add_primitive(
+            "other", std::function([](bool a_x) { return a_x; })));
+
+        std::stringstream l_stream;
+        assert_throws(write_checkpoint(l_stream, l_state, l_program,
+                                       l_other_scope, l_program),
+                      std::runtime_error);
+    }
+
+    // no file
+    assert(!load_checkpoint(
+        (std::filesystem::temp_directory_path() / "no_such_checkpoint")
+            .string(),
+        l_state, l_read_program, l_read_scope, l_program, {}));
+}
+
+void checkpoint_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_checkpoint_round_trip);
+    TEST(test_checkpoint_errors);
+}
+
+#endif
@@ -0,0 +1,45 @@
+#include "../include/choice.hpp"
+
+////////////////////////////////////////////////////
+//////////////// COMPARISON OPERATORS //////////////
+////////////////////////////////////////////////////
+
+bool operator<(const place_param_node& a_lhs, const place_param_node& a_rhs)
+{
+    return a_lhs.m_index < a_rhs.m_index;
+}
+bool operator<(const place_func_node& a_lhs, const place_func_node& a_rhs)
+{
+    return a_lhs.m_func < a_rhs.m_func;
+}
+bool operator<(const terminate&, const terminate&)
+{
+    return false;
+}
+bool operator<(const make_function&, const make_function&)
+{
+    return false;
+}
+
+bool canonical_less(const choice& a_lhs, const choice& a_rhs)
+{
+    if(a_lhs.index() != a_rhs.index())
+        return a_lhs.index() < a_rhs.index();
+
+    if(const auto* l_lhs = std::get_if<place_func_node>(&a_lhs))
+    {
+        const func* l_rhs_func = std::get<place_func_node>(a_rhs).m_func;
+
+        // REASON: reprs are almost always unique, and the address only
+        // breaks ties between funcs which share one
+        if(l_lhs->m_func->m_repr != l_rhs_func->m_repr)
+            return l_lhs->m_func->m_repr < l_rhs_func->m_repr;
+
+        return l_lhs->m_func < l_rhs_func;
+    }
+
+    if(const auto* l_lhs = std::get_if<place_param_node>(&a_lhs))
+        return *l_lhs < std::get<place_param_node>(a_rhs);
+
+    return false;
+}
@@ -0,0 +1,1904 @@
+#include "../include/dataset.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::multimap<std::type_index, size_t> data_schema::param_types() const
+{
+    const std::type_index TYPES[] = {typeid(bool), typeid(int),
+                                     typeid(double), typeid(std::string),
+                                     typeid(interned_string),
+                                     typeid(std::span<const int>)};
+
+    std::multimap<std::type_index, size_t> l_param_types;
+    for(size_t i = 0; i < m_params.size(); ++i)
+        l_param_types.emplace(TYPES[size_t(m_params[i].m_type)], i);
+
+    return l_param_types;
+}
+
+size_t dataset::size() const
+{
+    return m_labels.size();
+}
+
+void dataset::fill_row(size_t a_row, std::any* a_values) const
+{
+    for(size_t i = 0; i < m_columns.size(); ++i)
+        std::visit(
+            [a_row, &a_value = a_values[i]](const auto& a_column)
+            {
+                using T = typename std::decay_t<decltype(a_column)>::value_type;
+                assign_any(a_value, T(a_column[a_row]));
+            },
+            m_columns[i]);
+}
+
+std::vector<std::pair<std::vector<std::any>, bool>> dataset::rows() const
+{
+    return data_view(*this).rows();
+}
+
+// an empty column of the given type
+column make_column(const column_type& a_type)
+{
+    switch(a_type)
+    {
+        case column_type::boolean:
+            return std::vector<bool>();
+        case column_type::integer:
+            return std::vector<int>();
+        case column_type::real:
+            return std::vector<double>();
+        case column_type::string:
+            return std::vector<std::string>();
+        case column_type::interned:
+            return std::vector<interned_string>();
+        case column_type::integer_list:
+            return ragged_column<int>();
+    }
+
+    throw std::runtime_error("Error: unknown column type.");
+}
+
+// a dataset with empty columns of the schema's types
+dataset make_dataset(const data_schema& a_schema)
+{
+    dataset l_dataset{.m_schema = a_schema};
+
+    for(const auto& l_spec : a_schema.m_params)
+        l_dataset.m_columns.push_back(make_column(l_spec.m_type));
+
+    return l_dataset;
+}
+
+////////////////////////////////////////////////////
+/////////////////////// CSV ////////////////////////
+////////////////////////////////////////////////////
+
+// where each field of a record goes
+constexpr size_t SKIP_FIELD = std::numeric_limits<size_t>::max();
+constexpr size_t LABEL_FIELD = SKIP_FIELD - 1;
+
+// split a record into its fields, unquoting quoted ones. a_buffers holds
+// the text of fields with escaped quotes.
+void split_record(std::string_view a_record,
+                  std::vector<std::string_view>& a_fields,
+                  std::vector<std::string>& a_buffers)
+{
+    a_fields.clear();
+    a_buffers.clear();
+
+    // REASON: reserved so that views into the buffers stay valid
+    a_buffers.reserve(a_record.size());
+
+    size_t l_position = 0;
+
+    while(true)
+    {
+        if(l_position < a_record.size() && a_record[l_position] == '"')
+        {
+            // a quoted field, in which "" is a quote
+            std::string l_text;
+            size_t i = l_position + 1;
+
+            for(; i < a_record.size(); ++i)
+            {
+                if(a_record[i] != '"')
+                {
+                    l_text += a_record[i];
+                    continue;
+                }
+
+                if(i + 1 < a_record.size() && a_record[i + 1] == '"')
+                {
+                    l_text += '"';
+                    ++i;
+                    continue;
+                }
+
+                break;
+            }
+
+            if(i >= a_record.size())
+                throw std::runtime_error("Error: unterminated quote in csv.");
+
+            a_buffers.push_back(std::move(l_text));
+            a_fields.push_back(a_buffers.back());
+
+            l_position = i + 1;
+        }
+        else
+        {
+            size_t l_end = std::min(a_record.find(',', l_position),
+                                    a_record.size());
+            a_fields.push_back(
+                a_record.substr(l_position, l_end - l_position));
+            l_position = l_end;
+        }
+
+        if(l_position >= a_record.size())
+            return;
+
+        if(a_record[l_position] != ',')
+            throw std::runtime_error("Error: text after a quote in csv.");
+
+        ++l_position;
+    }
+}
+
+// parse the text of a field into a column
+template <typename T>
+void parse_field(std::string_view a_field, std::vector<T>& a_values)
+{
+    if constexpr(std::is_same_v<T, std::string>)
+    {
+        a_values.emplace_back(a_field);
+    }
+    else if constexpr(std::is_same_v<T, bool>)
+    {
+        if(a_field == "1" || a_field == "true" || a_field == "True" ||
+           a_field == "TRUE")
+            a_values.push_back(true);
+        else if(a_field == "0" || a_field == "false" || a_field == "False" ||
+                a_field == "FALSE")
+            a_values.push_back(false);
+        else
+            throw std::runtime_error("Error: \"" + std::string(a_field) +
+                                     "\" is not a bool.");
+    }
+    else
+    {
+        T l_value;
+        auto [l_end, l_error] = std::from_chars(
+            a_field.data(), a_field.data() + a_field.size(), l_value);
+
+        if(l_error != std::errc() || l_end != a_field.data() + a_field.size())
+            throw std::runtime_error("Error: \"" + std::string(a_field) +
+                                     "\" is not a number of the column's "
+                                     "type.");
+
+        a_values.push_back(l_value);
+    }
+}
+
+// parse a list of ints separated by spaces into a column of lists
+void parse_list(std::string_view a_field, ragged_column<int>& a_lists)
+{
+    std::vector<int> l_list;
+
+    for(size_t l_start = 0; l_start < a_field.size();)
+    {
+        size_t l_end = std::min(a_field.find(' ', l_start), a_field.size());
+
+        if(l_end > l_start)
+            parse_field(a_field.substr(l_start, l_end - l_start), l_list);
+
+        l_start = l_end + 1;
+    }
+
+    a_lists.push_back(l_list);
+}
+
+// parse whole records into the columns of a dataset. a_first_row is the
+// index of the first record, for errors.
+void parse_chunk(std::string_view a_chunk,
+                 const std::vector<size_t>& a_destinations,
+                 const size_t& a_first_row, dataset& a_dataset)
+{
+    std::vector<std::string_view> l_fields;
+    std::vector<std::string> l_buffers;
+
+    size_t l_row = a_first_row;
+
+    for(size_t l_start = 0; l_start < a_chunk.size();)
+    {
+        size_t l_end = std::min(a_chunk.find('\n', l_start), a_chunk.size());
+
+        // REASON: a newline inside quotes belongs to the field, so the
+        // record goes on until the quotes are balanced
+        while(l_end < a_chunk.size() &&
+              std::count(a_chunk.begin() + l_start, a_chunk.begin() + l_end,
+                         '"') %
+                      2 !=
+                  0)
+            l_end = std::min(a_chunk.find('\n', l_end + 1), a_chunk.size());
+
+        std::string_view l_record = a_chunk.substr(l_start, l_end - l_start);
+        l_start = l_end + 1;
+
+        if(!l_record.empty() && l_record.back() == '\r')
+            l_record.remove_suffix(1);
+
+        // REASON: blank lines are counted, as whole_records counts them
+        // in the first rows of later chunks
+        if(l_record.empty())
+        {
+            ++l_row;
+            continue;
+        }
+
+        try
+        {
+            split_record(l_record, l_fields, l_buffers);
+
+            if(l_fields.size() != a_destinations.size())
+                throw std::runtime_error(
+                    "Error: expected " + std::to_string(a_destinations.size()) +
+                    " fields but found " + std::to_string(l_fields.size()) +
+                    ".");
+
+            for(size_t i = 0; i < l_fields.size(); ++i)
+            {
+                if(a_destinations[i] == SKIP_FIELD)
+                    continue;
+
+                if(a_destinations[i] == LABEL_FIELD)
+                {
+                    std::vector<bool> l_label;
+                    parse_field(l_fields[i], l_label);
+                    a_dataset.m_labels.push_back(l_label.front());
+                    continue;
+                }
+
+                std::visit(
+                    [&a_dataset, &l_fields, i](auto& a_values)
+                    {
+                        using C = std::decay_t<decltype(a_values)>;
+
+                        if constexpr(std::is_same_v<
+                                         C, std::vector<interned_string>>)
+                            a_values.push_back(
+                                a_dataset.m_strings->intern(l_fields[i]));
+                        else if constexpr(std::is_same_v<C,
+                                                         ragged_column<int>>)
+                            parse_list(l_fields[i], a_values);
+                        else
+                            parse_field(l_fields[i], a_values);
+                    },
+                    a_dataset.m_columns[a_destinations[i]]);
+            }
+        }
+        catch(const std::runtime_error& a_error)
+        {
+            throw std::runtime_error(std::string(a_error.what()) +
+                                     " (csv row " + std::to_string(l_row) +
+                                     ")");
+        }
+
+        ++l_row;
+    }
+}
+
+// the length of the whole records at the start of the text, and the
+// number of them
+std::pair<size_t, size_t> whole_records(std::string_view a_text)
+{
+    size_t l_length = 0;
+    size_t l_count = 0;
+    bool l_quoted = false;
+
+    for(size_t i = 0; i < a_text.size(); ++i)
+    {
+        if(a_text[i] == '"')
+            l_quoted = !l_quoted;
+        else if(a_text[i] == '\n' && !l_quoted)
+        {
+            l_length = i + 1;
+            ++l_count;
+        }
+    }
+
+    return {l_length, l_count};
+}
+
+// append the columns of one dataset to another
+void append_dataset(dataset& a_dataset, dataset&& a_part)
+{
+    for(size_t i = 0; i < a_dataset.m_columns.size(); ++i)
+        std::visit(
+            [&a_dataset, &a_part, i](auto& a_values)
+            {
+                auto& l_part_values =
+                    std::get<std::decay_t<decltype(a_values)>>(
+                        a_part.m_columns[i]);
+
+                // REASON: the part's strings are in its own pool, and
+                // interning them in order keeps the ids those of a
+                // single threaded read
+                if constexpr(std::is_same_v<std::decay_t<decltype(a_values)>,
+                                            std::vector<interned_string>>)
+                    for(const interned_string& l_string : l_part_values)
+                        a_values.push_back(
+                            a_dataset.m_strings->intern(l_string.view()));
+                else if constexpr(std::is_same_v<
+                                      std::decay_t<decltype(a_values)>,
+                                      ragged_column<int>>)
+                    for(size_t j = 0; j < l_part_values.size(); ++j)
+                        a_values.push_back(l_part_values[j]);
+                else
+                    a_values.insert(
+                        a_values.end(),
+                        std::make_move_iterator(l_part_values.begin()),
+                        std::make_move_iterator(l_part_values.end()));
+            },
+            a_dataset.m_columns[i]);
+
+    a_dataset.m_labels.insert(a_dataset.m_labels.end(),
+                              a_part.m_labels.begin(), a_part.m_labels.end());
+}
+
+dataset read_csv(std::istream& a_stream, const data_schema& a_schema,
+                 const size_t& a_thread_count, const size_t& a_chunk_size)
+{
+    ////////////////////////////////////////////////////
+    ////////////////// READ THE HEADER /////////////////
+    ////////////////////////////////////////////////////
+    std::string l_header;
+    if(!std::getline(a_stream, l_header))
+        throw std::runtime_error("Error: csv has no header.");
+
+    if(!l_header.empty() && l_header.back() == '\r')
+        l_header.pop_back();
+
+    std::vector<std::string_view> l_names;
+    std::vector<std::string> l_buffers;
+    split_record(l_header, l_names, l_buffers);
+
+    // where each field goes, by its column's name
+    std::vector<size_t> l_destinations(l_names.size(), SKIP_FIELD);
+
+    auto l_find = [&l_names](const std::string& a_name)
+    {
+        auto l_it = std::find(l_names.begin(), l_names.end(), a_name);
+
+        if(l_it == l_names.end())
+            throw std::runtime_error("Error: csv has no column \"" + a_name +
+                                     "\".");
+
+        return l_it - l_names.begin();
+    };
+
+    // REASON: a column named twice would silently go to only one place
+    std::vector<std::string> l_schema_names{a_schema.m_label};
+    for(const data_schema::column_spec& l_param : a_schema.m_params)
+        l_schema_names.push_back(l_param.m_name);
+
+    std::sort(l_schema_names.begin(), l_schema_names.end());
+
+    auto l_duplicate =
+        std::adjacent_find(l_schema_names.begin(), l_schema_names.end());
+
+    if(l_duplicate != l_schema_names.end())
+        throw std::runtime_error("Error: schema names the column \"" +
+                                 *l_duplicate + "\" twice.");
+
+    for(size_t i = 0; i < a_schema.m_params.size(); ++i)
+        l_destinations[l_find(a_schema.m_params[i].m_name)] = i;
+
+    l_destinations[l_find(a_schema.m_label)] = LABEL_FIELD;
+
+    ////////////////////////////////////////////////////
+    ////////////////// READ THE RECORDS ////////////////
+    ////////////////////////////////////////////////////
+    dataset l_dataset = make_dataset(a_schema);
+
+    size_t l_thread_count = std::max<size_t>(a_thread_count, 1);
+    size_t l_chunk_size = std::max<size_t>(a_chunk_size, 1);
+
+    // text read but not yet parsed, which starts at a record
+    std::string l_pending;
+    size_t l_next_row = 0;
+
+    while(a_stream || !l_pending.empty())
+    {
+        // cut a batch of chunks, each of whole records
+        std::vector<std::string> l_chunks;
+        std::vector<size_t> l_first_rows;
+
+        while(l_chunks.size() < l_thread_count && a_stream)
+        {
+            size_t l_old_size = l_pending.size();
+            l_pending.resize(l_old_size + l_chunk_size);
+            a_stream.read(l_pending.data() + l_old_size, l_chunk_size);
+            l_pending.resize(l_old_size + a_stream.gcount());
+
+            // the last record need not end in a newline
+            if(!a_stream && !l_pending.empty() && l_pending.back() != '\n')
+                l_pending += '\n';
+
+            auto [l_length, l_count] = whole_records(l_pending);
+
+            if(l_length == 0)
+                continue;
+
+            l_first_rows.push_back(l_next_row);
+            l_next_row += l_count;
+
+            l_chunks.push_back(l_pending.substr(0, l_length));
+            l_pending.erase(0, l_length);
+        }
+
+        if(l_chunks.empty())
+        {
+            if(!l_pending.empty())
+                throw std::runtime_error("Error: unterminated quote in csv.");
+            break;
+        }
+
+        // parse the batch, a chunk per thread
+        // REASON: made one by one, since copies would share a pool
+        std::vector<dataset> l_parts;
+        for(size_t i = 0; i < l_chunks.size(); ++i)
+            l_parts.push_back(make_dataset(a_schema));
+        std::vector<std::exception_ptr> l_errors(l_chunks.size());
+        std::vector<std::thread> l_workers;
+
+        for(size_t i = 0; i < l_chunks.size(); ++i)
+            l_workers.emplace_back(
+                [&, i]()
+                {
+                    try
+                    {
+                        parse_chunk(l_chunks[i], l_destinations,
+                                    l_first_rows[i], l_parts[i]);
+                    }
+                    catch(...)
+                    {
+                        l_errors[i] = std::current_exception();
+                    }
+                });
+
+        for(std::thread& l_worker : l_workers)
+            l_worker.join();
+
+        for(const std::exception_ptr& l_error : l_errors)
+            if(l_error)
+                std::rethrow_exception(l_error);
+
+        for(dataset& l_part : l_parts)
+            append_dataset(l_dataset, std::move(l_part));
+    }
+
+    return l_dataset;
+}
+
+dataset read_csv(const std::string& a_path, const data_schema& a_schema,
+                 const size_t& a_thread_count, const size_t& a_chunk_size)
+{
+    std::ifstream l_file(a_path, std::ios::binary);
+
+    if(!l_file)
+        throw std::runtime_error("Error: failed to open " + a_path + ".");
+
+    return read_csv(l_file, a_schema, a_thread_count, a_chunk_size);
+}
+
+////////////////////////////////////////////////////
+//////////////////// COLUMN FILES //////////////////
+////////////////////////////////////////////////////
+
+constexpr char COLUMNS_MAGIC[8] = {'c', 'o', 'l', 'u', 'm', 'n', 's', '\0'};
+
+constexpr uint64_t COLUMNS_VERSION = 2;
+
+// REASON: every column starts 8 byte aligned, so that the file can be
+// mapped and its columns used in place
+constexpr size_t COLUMN_ALIGNMENT = 8;
+
+// the bytes of padding after a_size bytes
+size_t padding(size_t a_size)
+{
+    return (COLUMN_ALIGNMENT - a_size % COLUMN_ALIGNMENT) % COLUMN_ALIGNMENT;
+}
+
+// pad what follows a_size bytes to the alignment
+void write_padding(std::ostream& a_stream, size_t a_size)
+{
+    const char PADDING[COLUMN_ALIGNMENT] = {};
+    a_stream.write(PADDING, padding(a_size));
+}
+
+void write_bytes(std::ostream& a_stream, const void* a_data, size_t a_size)
+{
+    a_stream.write(static_cast<const char*>(a_data), a_size);
+    write_padding(a_stream, a_size);
+}
+
+void write_u64(std::ostream& a_stream, uint64_t a_value)
+{
+    write_bytes(a_stream, &a_value, sizeof(a_value));
+}
+
+void write_bits(std::ostream& a_stream, const std::vector<bool>& a_bits)
+{
+    std::vector<uint64_t> l_words((a_bits.size() + 63) / 64);
+
+    for(size_t i = 0; i < a_bits.size(); ++i)
+        l_words[i / 64] |= uint64_t(a_bits[i]) << (i % 64);
+
+    write_bytes(a_stream, l_words.data(), l_words.size() * sizeof(uint64_t));
+}
+
+void write_columns(std::ostream& a_stream, const dataset& a_dataset)
+{
+    const data_schema& l_schema = a_dataset.m_schema;
+
+    write_bytes(a_stream, COLUMNS_MAGIC, sizeof(COLUMNS_MAGIC));
+    write_u64(a_stream, COLUMNS_VERSION);
+    write_u64(a_stream, a_dataset.size());
+    write_u64(a_stream, l_schema.m_params.size());
+
+    // the schema
+    for(const auto& l_spec : l_schema.m_params)
+    {
+        write_u64(a_stream, uint64_t(l_spec.m_type));
+        write_u64(a_stream, l_spec.m_name.size());
+        write_bytes(a_stream, l_spec.m_name.data(), l_spec.m_name.size());
+    }
+
+    write_u64(a_stream, l_schema.m_label.size());
+    write_bytes(a_stream, l_schema.m_label.data(), l_schema.m_label.size());
+
+    // the columns
+    for(const column& l_column : a_dataset.m_columns)
+    {
+        if(const auto* l_bools = std::get_if<std::vector<bool>>(&l_column))
+        {
+            write_bits(a_stream, *l_bools);
+        }
+        else if(const auto* l_ints = std::get_if<std::vector<int>>(&l_column))
+        {
+            std::vector<int32_t> l_values(l_ints->begin(), l_ints->end());
+            write_bytes(a_stream, l_values.data(),
+                        l_values.size() * sizeof(int32_t));
+        }
+        else if(const auto* l_reals =
+                    std::get_if<std::vector<double>>(&l_column))
+        {
+            write_bytes(a_stream, l_reals->data(),
+                        l_reals->size() * sizeof(double));
+        }
+        else if(const auto* l_lists =
+                    std::get_if<ragged_column<int>>(&l_column))
+        {
+            std::vector<uint64_t> l_offsets(l_lists->m_offsets.begin(),
+                                            l_lists->m_offsets.end());
+            std::vector<int32_t> l_values(l_lists->m_values.begin(),
+                                          l_lists->m_values.end());
+
+            write_bytes(a_stream, l_offsets.data(),
+                        l_offsets.size() * sizeof(uint64_t));
+            write_bytes(a_stream, l_values.data(),
+                        l_values.size() * sizeof(int32_t));
+        }
+        else
+        {
+            std::vector<std::string_view> l_strings;
+
+            if(const auto* l_interned =
+                   std::get_if<std::vector<interned_string>>(&l_column))
+                for(const interned_string& l_string : *l_interned)
+                    l_strings.push_back(l_string.view());
+            else
+                for(const std::string& l_string :
+                    std::get<std::vector<std::string>>(l_column))
+                    l_strings.push_back(l_string);
+
+            // the distinct strings, in order of first appearance, and
+            // the index of each row's string among them
+            std::map<std::string_view, uint32_t> l_indices;
+            std::vector<std::string_view> l_dictionary;
+            std::vector<uint32_t> l_codes;
+
+            for(std::string_view l_string : l_strings)
+            {
+                auto [l_it, l_inserted] =
+                    l_indices.emplace(l_string, l_dictionary.size());
+
+                if(l_inserted)
+                    l_dictionary.push_back(l_string);
+
+                l_codes.push_back(l_it->second);
+            }
+
+            // the offset of each distinct string, then one past the last
+            std::vector<uint64_t> l_offsets{0};
+            for(std::string_view l_string : l_dictionary)
+                l_offsets.push_back(l_offsets.back() + l_string.size());
+
+            write_u64(a_stream, l_dictionary.size());
+            write_bytes(a_stream, l_offsets.data(),
+                        l_offsets.size() * sizeof(uint64_t));
+
+            for(std::string_view l_string : l_dictionary)
+                a_stream.write(l_string.data(), l_string.size());
+
+            write_padding(a_stream, l_offsets.back());
+
+            write_bytes(a_stream, l_codes.data(),
+                        l_codes.size() * sizeof(uint32_t));
+        }
+    }
+
+    write_bits(a_stream, a_dataset.m_labels);
+
+    if(!a_stream)
+        throw std::runtime_error("Error: failed to write columns.");
+}
+
+void write_columns(const std::string& a_path, const dataset& a_dataset)
+{
+    std::ofstream l_file(a_path, std::ios::binary);
+    write_columns(l_file, a_dataset);
+
+    if(!l_file.flush())
+        throw std::runtime_error("Error: failed to write " + a_path + ".");
+}
+
+// reads the sections of a column file in order, checking that each fits
+struct column_cursor
+{
+    const char* m_bytes;
+    size_t m_size;
+    size_t m_position = 0;
+
+    // the next a_count values of a_width bytes, and their padding
+    const char* take(const size_t& a_count, const size_t& a_width)
+    {
+        size_t l_remaining = m_size - m_position;
+
+        if(a_count > l_remaining / a_width ||
+           a_count * a_width + padding(a_count * a_width) > l_remaining)
+            throw std::runtime_error("Error: truncated column file.");
+
+        const char* l_result = m_bytes + m_position;
+        m_position += a_count * a_width + padding(a_count * a_width);
+
+        return l_result;
+    }
+
+    uint64_t take_u64()
+    {
+        uint64_t l_value;
+        std::memcpy(&l_value, take(1, sizeof(uint64_t)), sizeof(uint64_t));
+        return l_value;
+    }
+
+    std::string take_name()
+    {
+        size_t l_length = take_u64();
+        return std::string(take(l_length, 1), l_length);
+    }
+};
+
+column_file::column_file(const char* a_bytes, const size_t& a_size)
+{
+    column_cursor l_cursor{.m_bytes = a_bytes, .m_size = a_size};
+
+    if(a_size < sizeof(COLUMNS_MAGIC) ||
+       std::memcmp(l_cursor.take(sizeof(COLUMNS_MAGIC), 1), COLUMNS_MAGIC,
+                   sizeof(COLUMNS_MAGIC)) != 0)
+        throw std::runtime_error("Error: not a column file.");
+
+    if(l_cursor.take_u64() != COLUMNS_VERSION)
+        throw std::runtime_error("Error: unsupported column file version.");
+
+    m_size = l_cursor.take_u64();
+    size_t l_column_count = l_cursor.take_u64();
+
+    // the labels alone take a bit per row
+    if(m_size / 8 > a_size)
+        throw std::runtime_error("Error: malformed column file.");
+
+    // the schema
+    for(size_t i = 0; i < l_column_count; ++i)
+    {
+        uint64_t l_type = l_cursor.take_u64();
+
+        if(l_type > uint64_t(column_type::integer_list))
+            throw std::runtime_error("Error: unknown column type.");
+
+        std::string l_name = l_cursor.take_name();
+        m_schema.m_params.push_back({l_name, column_type(l_type)});
+    }
+
+    m_schema.m_label = l_cursor.take_name();
+
+    // the columns
+    size_t l_word_count = (m_size + 63) / 64;
+
+    for(const auto& l_spec : m_schema.m_params)
+    {
+        column_view l_view{.m_type = l_spec.m_type};
+
+        switch(l_spec.m_type)
+        {
+            case column_type::boolean:
+                l_view.m_values = l_cursor.take(l_word_count, sizeof(uint64_t));
+                break;
+            case column_type::integer:
+                l_view.m_values = l_cursor.take(m_size, sizeof(int32_t));
+                break;
+            case column_type::real:
+                l_view.m_values = l_cursor.take(m_size, sizeof(double));
+                break;
+            case column_type::string:
+            case column_type::interned:
+            {
+                size_t l_dictionary_size = l_cursor.take_u64();
+
+                if(l_dictionary_size > std::numeric_limits<uint32_t>::max())
+                    throw std::runtime_error("Error: malformed column file.");
+
+                std::vector<uint64_t> l_offsets(l_dictionary_size + 1);
+                std::memcpy(l_offsets.data(),
+                            l_cursor.take(l_offsets.size(), sizeof(uint64_t)),
+                            l_offsets.size() * sizeof(uint64_t));
+
+                if(l_offsets.front() != 0 ||
+                   !std::is_sorted(l_offsets.begin(), l_offsets.end()))
+                    throw std::runtime_error("Error: malformed column file.");
+
+                const char* l_text = l_cursor.take(l_offsets.back(), 1);
+
+                // REASON: the distinct strings are decoded once, so that a
+                // row costs a copy of a string, or of a handle, rather than a
+                // parse
+                if(l_spec.m_type == column_type::interned)
+                    l_view.m_strings = std::make_shared<string_pool>();
+
+                for(size_t i = 0; i < l_dictionary_size; ++i)
+                {
+                    std::string_view l_string(l_text + l_offsets[i],
+                                              l_offsets[i + 1] - l_offsets[i]);
+
+                    if(!l_view.m_strings)
+                        l_view.m_dictionary.emplace_back(l_string);
+                    else if(l_view.m_strings->intern(l_string).id() != i)
+                        throw std::runtime_error(
+                            "Error: malformed column file.");
+                }
+
+                l_view.m_values = l_cursor.take(m_size, sizeof(uint32_t));
+                break;
+            }
+            case column_type::integer_list:
+            {
+                const char* l_offsets =
+                    l_cursor.take(m_size + 1, sizeof(uint64_t));
+                l_view.m_values = l_offsets;
+
+                // REASON: only the last offset is read, which is all that
+                // locating the values takes
+                std::memcpy(&l_view.m_list_value_count,
+                            l_offsets + m_size * sizeof(uint64_t),
+                            sizeof(uint64_t));
+
+                l_view.m_list_values = reinterpret_cast<const int32_t*>(
+                    l_cursor.take(l_view.m_list_value_count, sizeof(int32_t)));
+                break;
+            }
+        }
+
+        m_columns.push_back(std::move(l_view));
+    }
+
+    m_labels = reinterpret_cast<const uint64_t*>(
+        l_cursor.take(l_word_count, sizeof(uint64_t)));
+}
+
+size_t column_file::size() const
+{
+    return m_size;
+}
+
+bool column_file::label(size_t a_row) const
+{
+    return (m_labels[a_row / 64] >> (a_row % 64)) & 1;
+}
+
+void column_file::fill_row(size_t a_row, std::any* a_values) const
+{
+    for(size_t i = 0; i < m_columns.size(); ++i)
+    {
+        const column_view& l_view = m_columns[i];
+
+        switch(l_view.m_type)
+        {
+            case column_type::boolean:
+                assign_any(a_values[i],
+                           bool((static_cast<const uint64_t*>(
+                                     l_view.m_values)[a_row / 64] >>
+                                 (a_row % 64)) &
+                                1));
+                break;
+            case column_type::integer:
+                assign_any(a_values[i], int(static_cast<const int32_t*>(
+                                            l_view.m_values)[a_row]));
+                break;
+            case column_type::real:
+                assign_any(a_values[i],
+                           static_cast<const double*>(l_view.m_values)[a_row]);
+                break;
+            case column_type::string:
+            {
+                // REASON: checked here rather than when opening, which would
+                // touch every page of the column
+                uint32_t l_code =
+                    static_cast<const uint32_t*>(l_view.m_values)[a_row];
+
+                if(l_code >= l_view.m_dictionary.size())
+                    throw std::runtime_error("Error: malformed column file.");
+
+                assign_any(a_values[i], l_view.m_dictionary[l_code]);
+                break;
+            }
+            case column_type::interned:
+            {
+                uint32_t l_code =
+                    static_cast<const uint32_t*>(l_view.m_values)[a_row];
+
+                if(l_code >= l_view.m_strings->size())
+                    throw std::runtime_error("Error: malformed column file.");
+
+                assign_any(a_values[i], l_view.m_strings->at(l_code));
+                break;
+            }
+            case column_type::integer_list:
+            {
+                const uint64_t* l_offsets =
+                    static_cast<const uint64_t*>(l_view.m_values);
+
+                if(l_offsets[a_row] > l_offsets[a_row + 1] ||
+                   l_offsets[a_row + 1] > l_view.m_list_value_count)
+                    throw std::runtime_error("Error: malformed column file.");
+
+                // REASON: a span into the file, so that the list is never
+                // copied
+                assign_any(a_values[i],
+                           std::span<const int>(
+                               l_view.m_list_values + l_offsets[a_row],
+                               l_offsets[a_row + 1] - l_offsets[a_row]));
+                break;
+            }
+        }
+    }
+}
+
+dataset read_columns(std::istream& a_stream)
+{
+    std::string l_text((std::istreambuf_iterator<char>(a_stream)),
+                       std::istreambuf_iterator<char>());
+
+    // REASON: copied into words, since the columns are read in place and
+    // must be aligned
+    std::vector<uint64_t> l_words((l_text.size() + 7) / 8);
+    std::memcpy(l_words.data(), l_text.data(), l_text.size());
+
+    column_file l_file(reinterpret_cast<const char*>(l_words.data()),
+                       l_text.size());
+
+    dataset l_dataset = make_dataset(l_file.m_schema);
+
+    std::vector<std::any> l_row(l_file.m_columns.size());
+
+    for(size_t i = 0; i < l_file.size(); ++i)
+    {
+        l_file.fill_row(i, l_row.data());
+
+        for(size_t j = 0; j < l_row.size(); ++j)
+            std::visit(
+                [&l_dataset, &l_row, j](auto& a_values)
+                {
+                    using T =
+                        typename std::decay_t<decltype(a_values)>::value_type;
+
+                    // the strings move from the file's pool to the dataset's
+                    if constexpr(std::is_same_v<T, interned_string>)
+                        a_values.push_back(l_dataset.m_strings->intern(
+                            std::any_cast<T>(l_row[j]).view()));
+                    else
+                        a_values.push_back(std::any_cast<T>(l_row[j]));
+                },
+                l_dataset.m_columns[j]);
+
+        l_dataset.m_labels.push_back(l_file.label(i));
+    }
+
+    return l_dataset;
+}
+
+dataset read_columns(const std::string& a_path)
+{
+    std::ifstream l_file(a_path, std::ios::binary);
+
+    if(!l_file)
+        throw std::runtime_error("Error: failed to open " + a_path + ".");
+
+    return read_columns(l_file);
+}
+
+file_mapping::file_mapping(const std::string& a_path)
+{
+    int l_descriptor = open(a_path.c_str(), O_RDONLY);
+
+    if(l_descriptor < 0)
+        throw std::runtime_error("Error: failed to open " + a_path + ".");
+
+    struct stat l_status;
+    if(fstat(l_descriptor, &l_status) != 0 || l_status.st_size == 0)
+    {
+        close(l_descriptor);
+        throw std::runtime_error("Error: failed to map " + a_path + ".");
+    }
+
+    m_size = l_status.st_size;
+
+    void* l_bytes =
+        mmap(nullptr, m_size, PROT_READ, MAP_SHARED, l_descriptor, 0);
+
+    // REASON: the mapping keeps the file open
+    close(l_descriptor);
+
+    if(l_bytes == MAP_FAILED)
+        throw std::runtime_error("Error: failed to map " + a_path + ".");
+
+    m_bytes = static_cast<const char*>(l_bytes);
+}
+
+file_mapping::~file_mapping()
+{
+    munmap(const_cast<char*>(m_bytes), m_size);
+}
+
+mapped_dataset::mapped_dataset(const std::string& a_path)
+    : m_mapping(a_path), m_file(m_mapping.m_bytes, m_mapping.m_size)
+{
+}
+
+////////////////////////////////////////////////////
+///////////////////// DATA VIEW ////////////////////
+////////////////////////////////////////////////////
+
+data_view::data_view(
+    const std::vector<std::pair<std::vector<std::any>, bool>>& a_rows)
+    : m_source(&a_rows)
+{
+}
+
+data_view::data_view(const dataset& a_dataset) : m_source(&a_dataset)
+{
+}
+
+data_view::data_view(const column_file& a_file) : m_source(&a_file)
+{
+}
+
+data_view::data_view(const mapped_dataset& a_dataset)
+    : m_source(&a_dataset.m_file)
+{
+}
+
+size_t data_view::size() const
+{
+    if(const auto* l_rows = std::get_if<0>(&m_source))
+        return (*l_rows)->size();
+
+    if(const auto* l_dataset = std::get_if<1>(&m_source))
+        return (*l_dataset)->size();
+
+    if(const auto* l_typed = std::get_if<3>(&m_source))
+        return l_typed->m_size;
+
+    return std::get<2>(m_source)->size();
+}
+
+size_t data_view::param_count() const
+{
+    if(const auto* l_rows = std::get_if<0>(&m_source))
+    {
+        size_t l_count = 0;
+        for(const auto& [l_x, l_y] : **l_rows)
+            l_count = std::max(l_count, l_x.size());
+        return l_count;
+    }
+
+    if(const auto* l_dataset = std::get_if<1>(&m_source))
+        return (*l_dataset)->m_columns.size();
+
+    if(const auto* l_typed = std::get_if<3>(&m_source))
+        return l_typed->m_param_count;
+
+    return std::get<2>(m_source)->m_columns.size();
+}
+
+bool data_view::label(size_t a_row) const
+{
+    if(const auto* l_rows = std::get_if<0>(&m_source))
+        return (**l_rows)[a_row].second;
+
+    if(const auto* l_dataset = std::get_if<1>(&m_source))
+        return (*l_dataset)->m_labels[a_row];
+
+    if(const auto* l_typed = std::get_if<3>(&m_source))
+        return l_typed->m_label(l_typed->m_data, a_row);
+
+    return std::get<2>(m_source)->label(a_row);
+}
+
+std::span<const std::any> data_view::params(size_t a_row,
+                                            std::any* a_buffer) const
+{
+    if(const auto* l_rows = std::get_if<0>(&m_source))
+        return (**l_rows)[a_row].first;
+
+    if(const auto* l_dataset = std::get_if<1>(&m_source))
+    {
+        (*l_dataset)->fill_row(a_row, a_buffer);
+        return {a_buffer, (*l_dataset)->m_columns.size()};
+    }
+
+    if(const auto* l_typed = std::get_if<3>(&m_source))
+    {
+        l_typed->m_fill_row(l_typed->m_data, a_row, a_buffer);
+        return {a_buffer, l_typed->m_param_count};
+    }
+
+    const column_file* l_file = std::get<2>(m_source);
+    l_file->fill_row(a_row, a_buffer);
+    return {a_buffer, l_file->m_columns.size()};
+}
+
+std::vector<std::pair<std::vector<std::any>, bool>> data_view::rows() const
+{
+    if(const auto* l_rows = std::get_if<0>(&m_source))
+        return **l_rows;
+
+    std::vector<std::pair<std::vector<std::any>, bool>> l_rows(size());
+
+    for(size_t i = 0; i < l_rows.size(); ++i)
+    {
+        l_rows[i].first.resize(param_count());
+        params(i, l_rows[i].first.data());
+        l_rows[i].second = label(i);
+    }
+
+    return l_rows;
+}
+
+#ifdef UNIT_TEST
+
+#include "../include/reduce.hpp"
+#include "test_utils.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+
+// a path for a file of a test, which the test removes
+std::string test_file_path(const std::string& a_name)
+{
+    return (std::filesystem::temp_directory_path() / a_name).string();
+}
+
+// the schema of the test csvs
+const data_schema TEST_SCHEMA{
+    .m_params =
+        {
+            {.m_name = "name", .m_type = column_type::string},
+            {.m_name = "age", .m_type = column_type::integer},
+            {.m_name = "score", .m_type = column_type::real},
+            {.m_name = "member", .m_type = column_type::boolean},
+        },
+    .m_label = "label",
+};
+
+void test_read_csv()
+{
+    // columns in another order, an unused column, quotes, and crlf
+    std::stringstream l_stream("unused,label,member,score,age,name\r\n"
+                               "x,1,true,1.5,30,alice\r\n"
+                               "y,0,0,-2,41,\"smith, bob\"\r\n"
+                               "\r\n"
+                               "z,false,FALSE,0.25,-7,\"say \"\"hi\"\"\"\r\n"
+                               "w,True,1,3e2,0,\"two\nlines\"");
+
+    dataset l_dataset = read_csv(l_stream, TEST_SCHEMA);
+
+    assert(l_dataset.size() == 4);
+    assert(l_dataset.m_labels == std::vector<bool>({true, false, false, true}));
+
+    assert(std::get<std::vector<std::string>>(l_dataset.m_columns[0]) ==
+           std::vector<std::string>(
+               {"alice", "smith, bob", "say \"hi\"", "two\nlines"}));
+    assert(std::get<std::vector<int>>(l_dataset.m_columns[1]) ==
+           std::vector<int>({30, 41, -7, 0}));
+    assert(std::get<std::vector<double>>(l_dataset.m_columns[2]) ==
+           std::vector<double>({1.5, -2, 0.25, 300}));
+    assert(std::get<std::vector<bool>>(l_dataset.m_columns[3]) ==
+           std::vector<bool>({true, false, false, true}));
+
+    // the rows are as learn_model takes them
+    auto l_rows = l_dataset.rows();
+    assert(l_rows.size() == 4);
+    assert(std::any_cast<std::string>(l_rows[1].first[0]) == "smith, bob");
+    assert(std::any_cast<int>(l_rows[1].first[1]) == 41);
+    assert(std::any_cast<double>(l_rows[1].first[2]) == -2);
+    assert(std::any_cast<bool>(l_rows[1].first[3]) == false);
+    assert(l_rows[3].second);
+
+    auto l_param_types = TEST_SCHEMA.param_types();
+    assert(l_param_types == (std::multimap<std::type_index, size_t>{
+                                {typeid(std::string), 0},
+                                {typeid(int), 1},
+                                {typeid(double), 2},
+                                {typeid(bool), 3},
+                            }));
+}
+
+void test_read_csv_chunks()
+{
+    // a csv of many rows
+    std::stringstream l_text;
+    l_text << "label,member,score,age,name" << std::endl;
+    for(int i = 0; i < 1000; ++i)
+        l_text << (i % 3 == 0) << "," << (i % 2) << "," << i * 0.5 << "," << i
+               << ",\"row, " << i << "\"" << std::endl;
+
+    std::stringstream l_whole_stream(l_text.str());
+    dataset l_whole = read_csv(l_whole_stream, TEST_SCHEMA, 1);
+
+    assert(l_whole.size() == 1000);
+    assert(std::get<std::vector<int>>(l_whole.m_columns[1])[999] == 999);
+
+    // small chunks, which split records, on several threads
+    for(size_t l_chunk_size : {1, 7, 64, 1000})
+    {
+        std::stringstream l_stream(l_text.str());
+        dataset l_chunked = read_csv(l_stream, TEST_SCHEMA, 4, l_chunk_size);
+
+        assert(l_chunked.m_columns == l_whole.m_columns);
+        assert(l_chunked.m_labels == l_whole.m_labels);
+    }
+}
+
+void test_read_csv_errors()
+{
+    auto l_read = [](const std::string& a_text)
+    {
+        std::stringstream l_stream(a_text);
+        return read_csv(l_stream, TEST_SCHEMA, 2, 16);
+    };
+
+    // no header
+    assert_throws(l_read(""), std::runtime_error);
+
+    // a missing column
+    assert_throws(l_read("label,member,score,age\n1,1,1,1\n"),
+                  std::runtime_error);
+
+    // values which do not parse
+    assert_throws(l_read("label,member,score,age,name\n1,1,1,x,a\n"),
+                  std::runtime_error);
+    assert_throws(l_read("label,member,score,age,name\n1,yes,1,1,a\n"),
+                  std::runtime_error);
+    assert_throws(l_read("label,member,score,age,name\n1,1,1.5.2,1,a\n"),
+                  std::runtime_error);
+
+    // the wrong number of fields
+    assert_throws(l_read("label,member,score,age,name\n1,1,1,1\n"),
+                  std::runtime_error);
+
+    // an unterminated quote
+    assert_throws(l_read("label,member,score,age,name\n1,1,1,1,\"a\n"),
+                  std::runtime_error);
+
+    // the row of an error is reported
+    try
+    {
+        l_read("label,member,score,age,name\n"
+               "1,1,1,1,a\n1,1,1,1,a\n1,1,1,oops,a\n");
+        assert(false);
+    }
+    catch(const std::runtime_error& a_error)
+    {
+        assert(std::string(a_error.what()).find("csv row 2") !=
+               std::string::npos);
+    }
+
+    // counting blank lines, whichever chunk they fall in
+    for(size_t l_chunk_size : {1, 16, 1000})
+    {
+        std::stringstream l_stream("label,member,score,age,name\n"
+                                   "1,1,1,1,a\n\n\n1,1,1,1,a\n"
+                                   "1,1,1,oops,a\n");
+
+        try
+        {
+            read_csv(l_stream, TEST_SCHEMA, 2, l_chunk_size);
+            assert(false);
+        }
+        catch(const std::runtime_error& a_error)
+        {
+            assert(std::string(a_error.what()).find("csv row 4") !=
+                   std::string::npos);
+        }
+    }
+
+    // a schema naming a column twice, or the label as a param
+    data_schema l_twice = TEST_SCHEMA;
+    l_twice.m_params.push_back({.m_name = "age", .m_type = column_type::real});
+
+    data_schema l_label_param = TEST_SCHEMA;
+    l_label_param.m_params.push_back(
+        {.m_name = "label", .m_type = column_type::boolean});
+
+    for(const data_schema& l_schema : {l_twice, l_label_param})
+    {
+        std::stringstream l_stream("label,member,score,age,name\n"
+                                   "1,1,1,1,a\n");
+
+        try
+        {
+            read_csv(l_stream, l_schema);
+            assert(false);
+        }
+        catch(const std::runtime_error& a_error)
+        {
+            assert(std::string(a_error.what()).find("twice") !=
+                   std::string::npos);
+        }
+    }
+}
+
+void test_columns_round_trip()
+{
+    std::stringstream l_text("label,member,score,age,name\n"
+                             "1,1,0.1,-3,\n"
+                             "0,0,1e300,2147483647,\"long string, which is "
+                             "long\"\n"
+                             "1,0,-0,7,x\n"
+                             "0,1,2,8,x\n");
+    dataset l_dataset = read_csv(l_text, TEST_SCHEMA);
+
+    std::stringstream l_stream;
+    write_columns(l_stream, l_dataset);
+
+    // every column is padded to the alignment
+    assert(l_stream.str().size() % 8 == 0);
+
+    dataset l_read = read_columns(l_stream);
+
+    assert(l_read.m_columns == l_dataset.m_columns);
+    assert(l_read.m_labels == l_dataset.m_labels);
+    assert(l_read.m_schema.m_label == "label");
+    assert(l_read.m_schema.param_types() == TEST_SCHEMA.param_types());
+    for(size_t i = 0; i < TEST_SCHEMA.m_params.size(); ++i)
+        assert(l_read.m_schema.m_params[i].m_name ==
+               TEST_SCHEMA.m_params[i].m_name);
+
+    // a file
+    const std::string l_path = test_file_path("test_columns");
+    write_columns(l_path, l_dataset);
+    assert(read_columns(l_path).m_columns == l_dataset.m_columns);
+
+    // not a column file, and a truncated one
+    std::stringstream l_bad("not columns at all");
+    assert_throws(read_columns(l_bad), std::runtime_error);
+
+    for(size_t i = 0; i < l_stream.str().size(); ++i)
+    {
+        std::stringstream l_truncated(l_stream.str().substr(0, i));
+        assert_throws(read_columns(l_truncated), std::runtime_error);
+    }
+
+    // another version
+    std::string l_other_version = l_stream.str();
+    l_other_version[8] = 1;
+    std::stringstream l_other_version_stream(l_other_version);
+    assert_throws(read_columns(l_other_version_stream), std::runtime_error);
+
+    std::remove(l_path.c_str());
+}
+
+void test_interned_columns()
+{
+    const data_schema SCHEMA{
+        .m_params =
+            {
+                {.m_name = "level", .m_type = column_type::interned},
+                {.m_name = "message", .m_type = column_type::string},
+            },
+        .m_label = "alert",
+    };
+
+    const std::string LEVELS[] = {"info", "warning", "error", "debug"};
+
+    std::stringstream l_text;
+    l_text << "level,message,alert" << std::endl;
+    for(int i = 0; i < 500; ++i)
+        l_text << LEVELS[i * 7 % 13 % 4] << ",message " << i << ","
+               << (i * 7 % 13 % 4 == 2) << std::endl;
+
+    std::stringstream l_whole_stream(l_text.str());
+    dataset l_whole = read_csv(l_whole_stream, SCHEMA, 1);
+
+    // each distinct string is stored once, with ids in order of first
+    // appearance
+    const auto& l_levels =
+        std::get<std::vector<interned_string>>(l_whole.m_columns[0]);
+
+    assert(l_whole.m_strings->size() == 4);
+    assert(l_levels[0].view() == "info");
+    assert(l_levels[0].id() == 0);
+    for(const interned_string& l_level : l_levels)
+        assert((l_level.m_entry == l_levels[0].m_entry) ==
+               (l_level.view() == "info"));
+
+    assert(SCHEMA.param_types().count(typeid(interned_string)) == 1);
+
+    // reading on several threads gives the same ids
+    std::stringstream l_chunked_stream(l_text.str());
+    dataset l_chunked = read_csv(l_chunked_stream, SCHEMA, 4, 100);
+
+    const auto& l_chunked_levels =
+        std::get<std::vector<interned_string>>(l_chunked.m_columns[0]);
+
+    assert(l_chunked.m_strings->size() == 4);
+    for(size_t i = 0; i < l_levels.size(); ++i)
+    {
+        assert(l_chunked_levels[i].id() == l_levels[i].id());
+        assert(l_chunked_levels[i].pool() == l_chunked.m_strings.get());
+    }
+
+    // the rows hold handles
+    std::vector<std::any> l_row(2);
+    l_whole.fill_row(1, l_row.data());
+    assert(std::any_cast<interned_string>(l_row[0]) == l_levels[1]);
+
+    // column files keep them interned
+    std::stringstream l_stream;
+    write_columns(l_stream, l_whole);
+    dataset l_read = read_columns(l_stream);
+
+    assert(l_read.m_columns == l_whole.m_columns);
+    assert(l_read.m_strings->size() == 4);
+    assert(std::get<std::vector<interned_string>>(l_read.m_columns[0])[0]
+               .pool() == l_read.m_strings.get());
+
+    const std::string l_path = test_file_path("test_interned_columns");
+    write_columns(l_path, l_whole);
+    mapped_dataset l_mapped(l_path);
+
+    std::vector<std::any> l_mapped_row(2);
+    for(size_t i = 0; i < l_whole.size(); ++i)
+    {
+        l_mapped.m_file.fill_row(i, l_mapped_row.data());
+
+        interned_string l_level =
+            std::any_cast<interned_string>(l_mapped_row[0]);
+        assert(l_level == l_levels[i]);
+        assert(l_level.id() == l_levels[i].id());
+    }
+
+    std::remove(l_path.c_str());
+}
+
+void test_list_columns()
+{
+    const data_schema SCHEMA{
+        .m_params =
+            {
+                {.m_name = "values", .m_type = column_type::integer_list},
+                {.m_name = "x", .m_type = column_type::integer},
+            },
+        .m_label = "y",
+    };
+
+    std::stringstream l_text;
+    l_text << "values,x,y" << std::endl;
+    l_text << "1 12 13,4,1" << std::endl;
+    l_text << ",2,0" << std::endl;
+    l_text << "\"-4  5\",3,1" << std::endl;
+    for(int i = 0; i < 200; ++i)
+        l_text << i << " " << i * 2 << "," << i << "," << i % 2 << std::endl;
+
+    std::stringstream l_whole_stream(l_text.str());
+    dataset l_whole = read_csv(l_whole_stream, SCHEMA, 1);
+
+    const auto& l_lists = std::get<ragged_column<int>>(l_whole.m_columns[0]);
+
+    assert(l_lists.size() == 203);
+    assert(std::ranges::equal(l_lists[0], std::vector<int>{1, 12, 13}));
+    assert(l_lists[1].empty());
+    assert(std::ranges::equal(l_lists[2], std::vector<int>{-4, 5}));
+    assert(std::ranges::equal(l_lists[202], std::vector<int>{199, 398}));
+    assert(SCHEMA.param_types().count(typeid(std::span<const int>)) == 1);
+
+    // reading on several threads gives the same lists
+    std::stringstream l_chunked_stream(l_text.str());
+    assert(read_csv(l_chunked_stream, SCHEMA, 4, 64).m_columns ==
+           l_whole.m_columns);
+
+    // a list which does not parse
+    std::stringstream l_bad("values,x,y\n1 a,1,1\n");
+    assert_throws(read_csv(l_bad, SCHEMA), std::runtime_error);
+
+    // the rows hold spans of the lists
+    std::vector<std::any> l_row(2);
+    l_whole.fill_row(0, l_row.data());
+    auto l_span = std::any_cast<std::span<const int>>(l_row[0]);
+    assert(l_span.data() == l_lists[0].data());
+
+    // column files keep them, and mapped ones are read in place
+    std::stringstream l_stream;
+    write_columns(l_stream, l_whole);
+    assert(read_columns(l_stream).m_columns == l_whole.m_columns);
+
+    const std::string l_path = test_file_path("test_list_columns");
+    write_columns(l_path, l_whole);
+    mapped_dataset l_mapped(l_path);
+
+    for(size_t i = 0; i < l_whole.size(); ++i)
+    {
+        l_mapped.m_file.fill_row(i, l_row.data());
+        l_span = std::any_cast<std::span<const int>>(l_row[0]);
+
+        assert(std::ranges::equal(l_span, l_lists[i]));
+        assert(l_span.empty() ||
+               (reinterpret_cast<const char*>(l_span.data()) >=
+                    l_mapped.m_mapping.m_bytes &&
+                reinterpret_cast<const char*>(l_span.data()) <
+                    l_mapped.m_mapping.m_bytes + l_mapped.m_mapping.m_size));
+    }
+
+    // offsets past the values
+    std::vector<uint64_t> l_words(l_stream.str().size() / 8);
+    std::memcpy(l_words.data(), l_stream.str().data(), l_stream.str().size());
+
+    column_file l_corrupt(reinterpret_cast<const char*>(l_words.data()),
+                          l_stream.str().size());
+    const_cast<uint64_t*>(static_cast<const uint64_t*>(
+        l_corrupt.m_columns[0].m_values))[1] = 1000000;
+
+    assert_throws(l_corrupt.fill_row(0, l_row.data()), std::runtime_error);
+
+    // typed datasets store spans as lists
+    std::vector<int> l_first{1, 2, 3};
+    std::vector<int> l_second{4};
+    typed_dataset<std::span<const int>, int> l_typed = make_typed_dataset(
+        std::vector<std::tuple<std::span<const int>, int>>{{l_first, 0},
+                                                           {l_second, 1}},
+        {true, false});
+
+    assert((std::get<0>(l_typed.m_columns).m_values ==
+            std::vector<int>{1, 2, 3, 4}));
+
+    l_typed.fill_row(1, l_row.data());
+    assert(std::ranges::equal(std::any_cast<std::span<const int>>(l_row[0]),
+                              l_second));
+
+    std::remove(l_path.c_str());
+}
+
+void test_mapped_dataset()
+{
+    // a dataset with few distinct strings
+    std::stringstream l_text;
+    l_text << "label,member,score,age,name" << std::endl;
+    for(int i = 0; i < 1000; ++i)
+        l_text << (i % 3 == 0) << "," << (i % 2) << "," << i * 0.5 << "," << i
+               << ",name " << i % 10 << std::endl;
+
+    dataset l_dataset = read_csv(l_text, TEST_SCHEMA);
+    const std::string l_path = test_file_path("test_mapped_columns");
+    write_columns(l_path, l_dataset);
+
+    mapped_dataset l_mapped(l_path);
+    const column_file& l_file = l_mapped.m_file;
+
+    assert(l_file.size() == 1000);
+    assert(l_file.m_schema.m_label == "label");
+    assert(l_file.m_schema.param_types() == TEST_SCHEMA.param_types());
+
+    // each distinct string is stored once
+    assert(l_file.m_columns[0].m_dictionary.size() == 10);
+
+    // every value is read in place
+    std::vector<std::any> l_expected(4);
+    std::vector<std::any> l_actual(4);
+
+    for(size_t i = 0; i < l_dataset.size(); ++i)
+    {
+        l_dataset.fill_row(i, l_expected.data());
+        l_file.fill_row(i, l_actual.data());
+
+        assert(std::any_cast<std::string>(l_actual[0]) ==
+               std::any_cast<std::string>(l_expected[0]));
+        assert(std::any_cast<int>(l_actual[1]) ==
+               std::any_cast<int>(l_expected[1]));
+        assert(std::any_cast<double>(l_actual[2]) ==
+               std::any_cast<double>(l_expected[2]));
+        assert(std::any_cast<bool>(l_actual[3]) ==
+               std::any_cast<bool>(l_expected[3]));
+        assert(l_file.label(i) == l_dataset.m_labels[i]);
+    }
+
+    // a missing file
+    assert_throws(mapped_dataset(test_file_path("no_such_columns")),
+                  std::runtime_error);
+
+    // a string index outside of the dictionary
+    std::stringstream l_stream;
+    write_columns(l_stream, l_dataset);
+    std::vector<uint64_t> l_words(l_stream.str().size() / 8);
+    std::memcpy(l_words.data(), l_stream.str().data(), l_stream.str().size());
+
+    column_file l_corrupt(reinterpret_cast<const char*>(l_words.data()),
+                          l_stream.str().size());
+    const_cast<uint32_t*>(static_cast<const uint32_t*>(
+        l_corrupt.m_columns[0].m_values))[5] = 10;
+
+    assert_throws(l_corrupt.fill_row(5, l_actual.data()), std::runtime_error);
+
+    std::remove(l_path.c_str());
+}
+
+void test_data_view()
+{
+    std::stringstream l_text;
+    l_text << "x,y" << std::endl;
+    for(int i = 0; i < 20; ++i)
+        l_text << i << "," << (i % 7 > 2) << std::endl;
+
+    const data_schema SCHEMA{
+        .m_params = {{.m_name = "x", .m_type = column_type::integer}},
+        .m_label = "y",
+    };
+
+    dataset l_dataset = read_csv(l_text, SCHEMA);
+    auto l_rows = l_dataset.rows();
+
+    const std::string l_path = test_file_path("test_view_columns");
+    write_columns(l_path, l_dataset);
+    mapped_dataset l_mapped(l_path);
+
+    // every source gives the same data points
+    std::vector<data_view> l_views{l_rows, l_dataset, l_mapped};
+    std::any l_buffer;
+
+    for(const data_view& l_view : l_views)
+    {
+        assert(l_view.size() == 20);
+        assert(l_view.param_count() == 1);
+
+        for(size_t i = 0; i < l_view.size(); ++i)
+        {
+            auto l_params = l_view.params(i, &l_buffer);
+            assert(l_params.size() == 1);
+            assert(std::any_cast<int>(l_params[0]) == int(i));
+            assert(l_view.label(i) == (i % 7 > 2));
+        }
+    }
+
+    // rows are read in place
+    assert(l_views[0].params(3, &l_buffer).data() == l_rows[3].first.data());
+
+    // and the search does not depend on the source
+    std::vector<std::string> l_reprs;
+
+    for(const data_view& l_view : l_views)
+    {
+        program l_program;
+        scope l_scope;
+
+        for(int l_threshold : {2, 6, 9, 13, 16})
+            l_scope.add_function(l_program.add_primitive(
+                "above_" + std::to_string(l_threshold),
+                std::function([l_threshold](int a_x)
+                              { return a_x > l_threshold; })));
+
+        model l_model = learn_model<int>(
+            l_program, l_scope, l_view,
+            search_config{.m_iterations = 200,
+                          .m_recursion_limit = 2,
+                          .m_exploration_constant = 10});
+
+        assert(inference_cost(l_model, l_view) ==
+               inference_cost(l_model, l_rows));
+
+        l_reprs.push_back(l_model.repr());
+    }
+
+    assert(l_reprs[0] == l_reprs[1]);
+    assert(l_reprs[0] == l_reprs[2]);
+
+    std::remove(l_path.c_str());
+}
+
+void test_typed_dataset()
+{
+    std::vector<std::tuple<int, std::string>> l_tuples;
+    std::vector<bool> l_labels;
+    for(int i = 0; i < 20; ++i)
+    {
+        l_tuples.emplace_back(i, i % 2 ? "odd" : "even");
+        l_labels.push_back(i > 12 && i % 2);
+    }
+
+    typed_dataset<int, std::string> l_dataset =
+        make_typed_dataset(l_tuples, l_labels);
+
+    assert(l_dataset.size() == 20);
+    assert(std::get<0>(l_dataset.m_columns)[7] == 7);
+    assert(std::get<1>(l_dataset.m_columns)[7] == "odd");
+
+    // read through a view into a buffer
+    data_view l_view(l_dataset);
+    std::vector<std::any> l_buffer(2);
+
+    assert(l_view.size() == 20);
+    assert(l_view.param_count() == 2);
+
+    for(size_t i = 0; i < l_view.size(); ++i)
+    {
+        auto l_params = l_view.params(i, l_buffer.data());
+        assert(l_params.data() == l_buffer.data());
+        assert(std::any_cast<int>(l_params[0]) == int(i));
+        assert(std::any_cast<std::string>(l_params[1]) ==
+               std::get<1>(l_tuples[i]));
+        assert(l_view.label(i) == l_labels[i]);
+    }
+
+    // rows and labels must match
+    l_labels.pop_back();
+    assert_throws(make_typed_dataset(l_tuples, l_labels), std::runtime_error);
+    l_labels.push_back(true);
+
+    // the search takes tuples, typed columns, or rows alike
+    auto l_learn = [&](auto a_learn)
+    {
+        program l_program;
+        scope l_scope;
+
+        l_scope.add_function(l_program.add_primitive(
+            "above_12", std::function([](int a_x) { return a_x > 12; })));
+        l_scope.add_function(l_program.add_primitive(
+            "is_odd", std::function([](std::string a_parity)
+                                    { return a_parity == "odd"; })));
+
+        return a_learn(l_program, l_scope,
+                       search_config{.m_iterations = 200,
+                                     .m_recursion_limit = 2,
+                                     .m_exploration_constant = 10})
+            .repr();
+    };
+
+    std::string l_from_tuples =
+        l_learn([&](program& a_program, scope& a_scope,
+                    const search_config& a_config)
+                { return learn_model(a_program, a_scope, l_tuples, l_labels,
+                                     a_config); });
+
+    std::string l_from_columns = l_learn(
+        [&](program& a_program, scope& a_scope, const search_config& a_config)
+        { return learn_model(a_program, a_scope, l_dataset, a_config); });
+
+    std::string l_from_rows = l_learn(
+        [&](program& a_program, scope& a_scope, const search_config& a_config)
+        {
+            return learn_model<int, std::string>(a_program, a_scope,
+                                                 l_view.rows(), a_config);
+        });
+
+    assert(l_from_tuples == l_from_columns);
+    assert(l_from_tuples == l_from_rows);
+}
+
+void test_learn_model_from_csv()
+{
+    // learn x > 5 from a csv
+    std::stringstream l_text;
+    l_text << "x,y" << std::endl;
+    for(int i = 0; i < 10; ++i)
+        l_text << i << "," << (i > 5) << std::endl;
+
+    const data_schema SCHEMA{
+        .m_params = {{.m_name = "x", .m_type = column_type::integer}},
+        .m_label = "y",
+    };
+
+    dataset l_dataset = read_csv(l_text, SCHEMA);
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "above_5", std::function([](int a_x) { return a_x > 5; })));
+
+    model l_model = learn_model<int>(
+        l_program, l_scope, l_dataset.rows(),
+        search_config{.m_iterations = 100,
+                      .m_recursion_limit = 2,
+                      .m_exploration_constant = 10});
+
+    assert(l_model.repr() == "[above_5(?0)] ? {1} : {0}");
+}
+
+void dataset_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_read_csv);
+    TEST(test_read_csv_chunks);
+    TEST(test_read_csv_errors);
+    TEST(test_columns_round_trip);
+    TEST(test_interned_columns);
+    TEST(test_list_columns);
+    TEST(test_mapped_dataset);
+    TEST(test_data_view);
+    TEST(test_typed_dataset);
+    TEST(test_learn_model_from_csv);
+}
+
+#endif
+
+#ifdef BENCHMARK
+
+#include "bench_utils.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+
+void bench_read_csv()
+{
+    constexpr size_t ROW_COUNT = 200000;
+
+    const data_schema SCHEMA{
+        .m_params =
+            {
+                {.m_name = "a", .m_type = column_type::integer},
+                {.m_name = "b", .m_type = column_type::real},
+                {.m_name = "c", .m_type = column_type::boolean},
+                {.m_name = "d", .m_type = column_type::string},
+            },
+        .m_label = "y",
+    };
+
+    std::stringstream l_text;
+    l_text << "a,b,c,d,y" << std::endl;
+    for(size_t i = 0; i < ROW_COUNT; ++i)
+        l_text << i << "," << i * 0.25 << "," << (i % 2) << ",s" << i % 97
+               << "," << (i % 3 == 0) << std::endl;
+
+    const std::string TEXT = l_text.str();
+
+    for(size_t l_thread_count : {1, 4})
+    {
+        bench("read_csv",
+              {{"row_count", ROW_COUNT}, {"thread_count", l_thread_count}},
+              [&]()
+              {
+                  std::stringstream l_stream(TEXT);
+                  do_not_optimize(read_csv(l_stream, SCHEMA, l_thread_count,
+                                           size_t{1} << 20));
+              });
+    }
+}
+
+void bench_open_columns()
+{
+    constexpr size_t ROW_COUNT = 200000;
+
+    dataset l_dataset{
+        .m_schema = {.m_params = {{.m_name = "a",
+                                   .m_type = column_type::integer},
+                                  {.m_name = "b",
+                                   .m_type = column_type::string}},
+                     .m_label = "y"},
+        .m_columns = {std::vector<int>(), std::vector<std::string>()},
+    };
+
+    for(size_t i = 0; i < ROW_COUNT; ++i)
+    {
+        std::get<std::vector<int>>(l_dataset.m_columns[0]).push_back(i);
+        std::get<std::vector<std::string>>(l_dataset.m_columns[1])
+            .push_back("s" + std::to_string(i % 97));
+        l_dataset.m_labels.push_back(i % 3 == 0);
+    }
+
+    const std::string l_path =
+        (std::filesystem::temp_directory_path() / "bench_columns").string();
+    write_columns(l_path, l_dataset);
+
+    bench("read_columns", {{"row_count", ROW_COUNT}},
+          [&]() { do_not_optimize(read_columns(l_path)); });
+
+    bench("mapped_dataset", {{"row_count", ROW_COUNT}},
+          [&]()
+          {
+              mapped_dataset l_mapped(l_path);
+              do_not_optimize(l_mapped.m_file.size());
+          });
+
+    std::remove(l_path.c_str());
+}
+
+void bench_data_view()
+{
+    constexpr size_t ROW_COUNT = 100000;
+
+    std::vector<std::tuple<int, double>> l_tuples;
+    std::vector<bool> l_labels;
+    for(size_t i = 0; i < ROW_COUNT; ++i)
+    {
+        l_tuples.emplace_back(i, i * 0.5);
+        l_labels.push_back(i % 3 == 0);
+    }
+
+    auto l_typed = make_typed_dataset(l_tuples, l_labels);
+    auto l_rows = data_view(l_typed).rows();
+
+    // a pass over the params of every row, as the learner makes
+    auto l_pass = [](const data_view& a_view)
+    {
+        std::vector<std::any> l_buffer(a_view.param_count());
+        int l_sum = 0;
+
+        for(size_t i = 0; i < a_view.size(); ++i)
+            l_sum += std::any_cast<int>(
+                a_view.params(i, l_buffer.data()).front());
+
+        do_not_optimize(l_sum);
+    };
+
+    bench("data_view::params", {{"row_count", ROW_COUNT}, {"typed", 0}},
+          [&]() { l_pass(l_rows); });
+
+    bench("data_view::params", {{"row_count", ROW_COUNT}, {"typed", 1}},
+          [&]() { l_pass(l_typed); });
+
+    // building the rows a source of typed data replaces
+    bench("data_view::rows", {{"row_count", ROW_COUNT}},
+          [&]() { do_not_optimize(data_view(l_typed).rows()); });
+}
+
+void dataset_bench_main()
+{
+    BENCH(bench_read_csv);
+    BENCH(bench_open_columns);
+    BENCH(bench_data_view);
+}
+
+#endif // BENCHMARK
@@ -0,0 +1,378 @@
+#include "../include/duplicates.hpp"
+#include "../include/search_tree.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <typeindex>
+#include <unordered_map>
+
+// how the values of a type are hashed and compared
+struct value_traits
+{
+    uint64_t (*m_hash)(const std::any&);
+    bool (*m_equal)(const std::any&, const std::any&);
+};
+
+template <typename T>
+uint64_t hash_value(const T& a_value)
+{
+    return std::hash<T>()(a_value);
+}
+
+uint64_t hash_value(const interned_string& a_value)
+{
+    return std::hash<std::string_view>()(a_value.view());
+}
+
+uint64_t hash_value(const std::span<const int>& a_value)
+{
+    uint64_t l_hash = a_value.size();
+    for(int l_int : a_value)
+        l_hash = mix_key(l_hash, uint32_t(l_int));
+    return l_hash;
+}
+
+template <typename T>
+bool equal_values(const T& a_x, const T& a_y)
+{
+    return a_x == a_y;
+}
+
+bool equal_values(const std::span<const int>& a_x,
+                  const std::span<const int>& a_y)
+{
+    return std::ranges::equal(a_x, a_y);
+}
+
+template <typename T>
+std::pair<std::type_index, value_traits> make_value_traits()
+{
+    return {
+        typeid(T),
+        value_traits{
+            .m_hash = [](const std::any& a_value) -> uint64_t
+            { return hash_value(*std::any_cast<T>(&a_value)); },
+            .m_equal = [](const std::any& a_x, const std::any& a_y)
+            {
+                return equal_values(*std::any_cast<T>(&a_x),
+                                    *std::any_cast<T>(&a_y));
+            },
+        },
+    };
+}
+
+// the traits of the types a dataset column can hold
+const value_traits* find_value_traits(const std::type_index& a_type)
+{
+    static const std::unordered_map<std::type_index, value_traits> TRAITS{
+        make_value_traits<bool>(),
+        make_value_traits<int>(),
+        make_value_traits<double>(),
+        make_value_traits<std::string>(),
+        make_value_traits<interned_string>(),
+        make_value_traits<std::span<const int>>(),
+    };
+
+    auto l_traits = TRAITS.find(a_type);
+    return l_traits == TRAITS.end() ? nullptr : &l_traits->second;
+}
+
+// the hash of the params of a row, or nothing if one of them cannot
+// be hashed
+std::optional<uint64_t> hash_params(std::span<const std::any> a_params)
+{
+    uint64_t l_hash = a_params.size();
+
+    for(const std::any& l_param : a_params)
+    {
+        const value_traits* l_traits = find_value_traits(l_param.type());
+
+        if(l_traits == nullptr)
+            return std::nullopt;
+
+        l_hash = mix_key(l_hash, l_param.type().hash_code());
+        l_hash = mix_key(l_hash, l_traits->m_hash(l_param));
+    }
+
+    return l_hash;
+}
+
+// whether the params of two rows of equal hashes are equal
+bool equal_params(std::span<const std::any> a_x, std::span<const std::any> a_y)
+{
+    if(a_x.size() != a_y.size())
+        return false;
+
+    for(size_t i = 0; i < a_x.size(); ++i)
+        if(a_x[i].type() != a_y[i].type() ||
+           !find_value_traits(a_x[i].type())->m_equal(a_x[i], a_y[i]))
+            return false;
+
+    return true;
+}
+
+unique_rows collapse_duplicates(const data_view& a_data)
+{
+    constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    // the rows of equal params
+    struct group
+    {
+        // the first row of each label
+        size_t m_first[2] = {NONE, NONE};
+        size_t m_count[2] = {0, 0};
+    };
+
+    std::vector<group> l_groups;
+    std::vector<size_t> l_group_of_row(a_data.size());
+
+    // the groups of each hash
+    std::unordered_map<uint64_t, std::vector<size_t>> l_groups_of_hash;
+
+    // REASON: two buffers, since a row is compared with an earlier one
+    // while its params are held
+    std::vector<std::any> l_buffer(a_data.param_count());
+    std::vector<std::any> l_other_buffer(a_data.param_count());
+
+    for(size_t i = 0; i < a_data.size(); ++i)
+    {
+        std::span<const std::any> l_x = a_data.params(i, l_buffer.data());
+        std::optional<uint64_t> l_hash = hash_params(l_x);
+
+        size_t l_group = NONE;
+
+        if(l_hash)
+        {
+            std::vector<size_t>& l_candidates = l_groups_of_hash[*l_hash];
+
+            for(size_t l_candidate : l_candidates)
+            {
+                const group& l_other = l_groups[l_candidate];
+                size_t l_other_row = std::min(l_other.m_first[0],
+                                              l_other.m_first[1]);
+
+                if(equal_params(l_x, a_data.params(l_other_row,
+                                                   l_other_buffer.data())))
+                {
+                    l_group = l_candidate;
+                    break;
+                }
+            }
+
+            if(l_group == NONE)
+                l_candidates.push_back(l_groups.size());
+        }
+
+        if(l_group == NONE)
+        {
+            l_group = l_groups.size();
+            l_groups.emplace_back();
+        }
+
+        bool l_label = a_data.label(i);
+        group& l_row_group = l_groups[l_group];
+
+        if(l_row_group.m_count[l_label]++ == 0)
+            l_row_group.m_first[l_label] = i;
+
+        l_group_of_row[i] = l_group;
+    }
+
+    // the first row of each distinct data point, and its count
+    std::vector<std::pair<size_t, size_t>> l_firsts;
+    for(const group& l_group : l_groups)
+        for(bool l_label : {false, true})
+            if(l_group.m_count[l_label] > 0)
+                l_firsts.emplace_back(l_group.m_first[l_label],
+                                      l_group.m_count[l_label]);
+
+    std::sort(l_firsts.begin(), l_firsts.end());
+
+    unique_rows l_result;
+    l_result.m_rows.reserve(l_firsts.size());
+    l_result.m_weights.reserve(l_firsts.size());
+
+    for(const auto& [l_row, l_count] : l_firsts)
+    {
+        l_result.m_rows.push_back(l_row);
+        l_result.m_weights.push_back(l_count);
+    }
+
+    // groups holding both labels, in order of their first rows
+    std::vector<size_t> l_conflict_of_group(l_groups.size(), NONE);
+
+    for(size_t i = 0; i < a_data.size(); ++i)
+    {
+        const group& l_group = l_groups[l_group_of_row[i]];
+
+        if(l_group.m_count[0] == 0 || l_group.m_count[1] == 0)
+            continue;
+
+        size_t& l_conflict = l_conflict_of_group[l_group_of_row[i]];
+
+        if(l_conflict == NONE)
+        {
+            l_conflict = l_result.m_conflicts.size();
+            l_result.m_conflicts.emplace_back();
+        }
+
+        l_result.m_conflicts[l_conflict].push_back(i);
+    }
+
+    return l_result;
+}
+
+void check_conflicts(const unique_rows& a_unique)
+{
+    if(a_unique.m_conflicts.empty())
+        return;
+
+    std::stringstream l_rows;
+    for(size_t l_row : a_unique.m_conflicts.front())
+        l_rows << " " << l_row;
+
+    throw conflicting_rows(
+        "Error: " + std::to_string(a_unique.m_conflicts.size()) +
+        " sets of rows have equal params but different labels, the "
+        "first being rows" +
+        l_rows.str() + ".");
+}
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+
+void test_collapse_duplicates()
+{
+    // rows which repeat, one of which also conflicts
+    std::vector<std::pair<std::vector<std::any>, bool>> l_rows{
+        {{1, std::string("a")}, false},
+        {{2, std::string("a")}, true},
+        {{1, std::string("a")}, false},
+        {{1, std::string("b")}, true},
+        {{2, std::string("a")}, false},
+        {{1, std::string("a")}, false},
+    };
+
+    unique_rows l_unique = collapse_duplicates(l_rows);
+
+    assert(l_unique.m_rows == std::vector<size_t>({0, 1, 3, 4}));
+    assert(l_unique.m_weights == std::vector<size_t>({3, 1, 1, 1}));
+    assert(l_unique.m_conflicts ==
+           std::vector<std::vector<size_t>>({{1, 4}}));
+
+    // the conflicting rows are named
+    try
+    {
+        check_conflicts(l_unique);
+        assert(false);
+    }
+    catch(const std::runtime_error& a_error)
+    {
+        assert(std::string(a_error.what()).find("rows 1 4.") !=
+               std::string::npos);
+    }
+
+    // rows of equal values of different types are distinct
+    std::vector<std::pair<std::vector<std::any>, bool>> l_typed_rows{
+        {{1}, false},
+        {{1.0}, true},
+        {{true}, true},
+    };
+    assert(collapse_duplicates(l_typed_rows).m_rows.size() == 3);
+    check_conflicts(collapse_duplicates(l_typed_rows));
+
+    // as are rows of params which cannot be compared
+    std::vector<std::pair<std::vector<std::any>, bool>> l_opaque_rows{
+        {{std::vector<int>{1}}, false},
+        {{std::vector<int>{1}}, true},
+    };
+    assert(collapse_duplicates(l_opaque_rows).m_rows.size() == 2);
+    assert(collapse_duplicates(l_opaque_rows).m_conflicts.empty());
+
+    // no rows have no duplicates
+    std::vector<std::pair<std::vector<std::any>, bool>> l_no_rows;
+    assert(collapse_duplicates(l_no_rows).m_rows.empty());
+}
+
+void test_collapse_duplicates_columns()
+{
+    // lists and interned strings, read from columns
+    string_pool l_pool;
+    typed_dataset<std::span<const int>, interned_string> l_data;
+
+    const std::vector<std::vector<int>> LISTS{{1, 2}, {1, 2, 3}, {}, {1, 2}};
+    const std::vector<std::string> STRINGS{"x", "x", "y", "x"};
+
+    for(size_t i = 0; i < 100; ++i)
+    {
+        std::get<0>(l_data.m_columns).push_back(LISTS[i % 4]);
+        std::get<1>(l_data.m_columns).push_back(l_pool.intern(STRINGS[i % 4]));
+        l_data.m_labels.push_back(i % 4 == 1);
+    }
+
+    unique_rows l_unique = collapse_duplicates(l_data);
+
+    // rows 0 and 3 hold the same list and string
+    assert(l_unique.m_rows == std::vector<size_t>({0, 1, 2}));
+    assert(l_unique.m_weights == std::vector<size_t>({50, 25, 25}));
+    assert(l_unique.m_conflicts.empty());
+
+    // a row of the first list and string with the other label conflicts
+    l_data.m_labels[99] = true;
+    l_unique = collapse_duplicates(l_data);
+
+    assert(l_unique.m_conflicts.size() == 1);
+    assert(l_unique.m_conflicts.front().size() == 50);
+    assert(l_unique.m_conflicts.front().front() == 0);
+    assert(l_unique.m_conflicts.front().back() == 99);
+    assert_throws(check_conflicts(l_unique), conflicting_rows);
+}
+
+void duplicates_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_collapse_duplicates);
+    TEST(test_collapse_duplicates_columns);
+}
+
+#endif
+
+#ifdef BENCHMARK
+
+#include "bench_utils.hpp"
+
+void bench_collapse_duplicates()
+{
+    constexpr size_t ROW_COUNT = 100000;
+
+    // rows of few distinct params, as in logs
+    for(size_t l_distinct_count : {100, 100000})
+    {
+        std::vector<std::tuple<int, int>> l_tuples;
+        std::vector<bool> l_labels;
+        for(size_t i = 0; i < ROW_COUNT; ++i)
+        {
+            size_t l_value = i % l_distinct_count;
+            l_tuples.emplace_back(l_value % 1000, l_value / 1000);
+            l_labels.push_back(l_value % 3 == 0);
+        }
+
+        auto l_typed = make_typed_dataset(l_tuples, l_labels);
+
+        bench("collapse_duplicates",
+              {{"row_count", ROW_COUNT}, {"distinct_count", l_distinct_count}},
+              [&]() { do_not_optimize(collapse_duplicates(l_typed)); });
+    }
+}
+
+void duplicates_bench_main()
+{
+    BENCH(bench_collapse_duplicates);
+}
+
+#endif
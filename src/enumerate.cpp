@@ -0,0 +1,492 @@
+#include "../include/enumerate.hpp"
+#include <set>
+#include <stdexcept>
+#include <string>
+
+// a term, along with its values on each data point
+struct term
+{
+    func::body m_body;
+    std::vector<std::any> m_values;
+    size_t m_size = 0;
+};
+
+// append the bytes of a value to a key, if it is of type T
+template <typename T>
+bool encode_as(const std::any& a_value, std::string& a_key)
+{
+    const T* l_value = std::any_cast<T>(&a_value);
+
+    if(l_value == nullptr)
+        return false;
+
+    a_key.append(reinterpret_cast<const char*>(l_value), sizeof(T));
+
+    return true;
+}
+
+// get a key which is equal for equal value vectors. nothing is
+// returned for value types that cannot be compared.
+std::optional<std::string> fingerprint(const std::vector<std::any>& a_values)
+{
+    std::string l_key;
+
+    for(const std::any& l_value : a_values)
+    {
+        if(const auto* l_string = std::any_cast<std::string>(&l_value))
+        {
+            // prefix the length so that concatenations are unambiguous
+            size_t l_size = l_string->size();
+            l_key.append(reinterpret_cast<const char*>(&l_size),
+                         sizeof(l_size));
+            l_key.append(*l_string);
+            continue;
+        }
+
+        if(!encode_as<bool>(l_value, l_key) &&
+           !encode_as<int>(l_value, l_key) &&
+           !encode_as<size_t>(l_value, l_key) &&
+           !encode_as<double>(l_value, l_key) &&
+           !encode_as<char>(l_value, l_key))
+            return std::nullopt;
+    }
+
+    return l_key;
+}
+
+// choose a term for each arg of the func (of the given types) such that
+// the sizes sum to a_remaining, calling a_visit on each choice. stops and
+// returns true as soon as a_visit does. args of a commutative func are
+// only chosen in bank order, and the first arg of an associative func is
+// never the func itself.
+bool combine_args(
+    const std::map<std::type_index, std::vector<std::vector<term>>>& a_bank,
+    const func* a_func, const std::vector<std::type_index>& a_arg_types,
+    size_t a_arg, size_t a_remaining, std::vector<const term*>& a_args,
+    const std::function<bool(const std::vector<const term*>&)>& a_visit)
+{
+    if(a_arg == a_arg_types.size())
+        return a_remaining == 0 && a_visit(a_args);
+
+    const auto& l_terms_by_size = a_bank.at(a_arg_types[a_arg]);
+
+    // leave at least one node for each remaining arg
+    size_t l_args_left = a_arg_types.size() - a_arg - 1;
+
+    // REASON: terms of one size are never moved once combined, so their
+    // addresses give their order in the bank
+    const term* l_previous =
+        a_func->m_properties.m_commutative && a_arg > 0 ? a_args[a_arg - 1]
+                                                        : nullptr;
+
+    for(size_t l_size = l_previous ? l_previous->m_size : 1;
+        l_size + l_args_left <= a_remaining; ++l_size)
+    {
+        for(const term& l_term : l_terms_by_size[l_size])
+        {
+            if(l_previous != nullptr && l_size == l_previous->m_size &&
+               &l_term < l_previous)
+                continue;
+
+            if(a_func->m_properties.m_associative && a_arg == 0 &&
+               std::holds_alternative<const func*>(l_term.m_body.m_functor) &&
+               std::get<const func*>(l_term.m_body.m_functor) == a_func)
+                continue;
+
+            a_args[a_arg] = &l_term;
+
+            if(combine_args(a_bank, a_func, a_arg_types, a_arg + 1,
+                            a_remaining - l_size, a_args, a_visit))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+std::optional<func::body> enumerate_binning_function(
+    const scope& a_scope,
+    const std::multimap<std::type_index, size_t>& a_param_types,
+    const std::vector<std::pair<std::vector<std::any>, bool>>& a_data,
+    const size_t& a_max_size)
+{
+    const std::type_index BINNING_RETURN_TYPE = std::type_index(typeid(bool));
+
+    ////////////////////////////////////////////////////
+    ////////////////// PREPARE THE BANK ////////////////
+    ////////////////////////////////////////////////////
+
+    // all known terms, by type then by node count
+    std::map<std::type_index, std::vector<std::vector<term>>> l_bank;
+
+    // the fingerprints of all known terms, by type
+    std::map<std::type_index, std::set<std::string>> l_seen;
+
+    // REASON: size the bank up front so that adding terms never
+    // invalidates the terms being combined
+    auto l_prepare = [&l_bank, &a_max_size](const std::type_index& a_type)
+    { l_bank[a_type].resize(a_max_size + 1); };
+
+    l_prepare(BINNING_RETURN_TYPE);
+    for(const auto& [l_type, l_index] : a_param_types)
+        l_prepare(l_type);
+    for(const auto& [l_type, l_func] : a_scope.m_nullaries)
+        l_prepare(l_type);
+    for(const auto& [l_type, l_func] : a_scope.m_non_nullaries)
+    {
+        l_prepare(l_type);
+        for(const auto& [l_param_type, l_index] : l_func->m_param_types)
+            l_prepare(l_param_type);
+    }
+
+    // the smallest term which gives a non-degenerate split
+    std::optional<func::body> l_split;
+
+    // add a term to the bank unless it is equivalent to a known
+    // term. returns true if it perfectly separates the data.
+    auto l_add = [&](const std::type_index& a_type, size_t a_size,
+                     term&& a_term)
+    {
+        std::optional<std::string> l_key = fingerprint(a_term.m_values);
+
+        if(l_key.has_value() && !l_seen[a_type].insert(*l_key).second)
+            return false;
+
+        a_term.m_size = a_size;
+
+        if(a_type == BINNING_RETURN_TYPE)
+        {
+            size_t l_positive_count = 0;
+            size_t l_matching_count = 0;
+
+            for(size_t i = 0; i < a_data.size(); ++i)
+            {
+                bool l_value = std::any_cast<bool>(a_term.m_values[i]);
+                l_positive_count += l_value;
+                l_matching_count += l_value == a_data[i].second;
+            }
+
+            // if both bins are non-empty, the split is useful
+            if(!l_split.has_value() && l_positive_count > 0 &&
+               l_positive_count < a_data.size())
+                l_split = a_term.m_body;
+
+            // a split that matches (or inverts) the labels is perfect
+            if(l_matching_count == a_data.size() || l_matching_count == 0)
+            {
+                l_split = a_term.m_body;
+                return true;
+            }
+        }
+
+        l_bank[a_type][a_size].push_back(std::move(a_term));
+
+        return false;
+    };
+
+    ////////////////////////////////////////////////////
+    ////////////////// ENUMERATE SIZE 1 ////////////////
+    ////////////////////////////////////////////////////
+    if(a_max_size == 0)
+        return std::nullopt;
+
+    // params
+    for(const auto& [l_type, l_index] : a_param_types)
+    {
+        term l_term{.m_body = func::body{.m_functor = func::param{l_index}}};
+
+        for(const auto& [l_x, l_y] : a_data)
+            l_term.m_values.push_back(l_x[l_index]);
+
+        if(l_add(l_type, 1, std::move(l_term)))
+            return l_split;
+    }
+
+    // nullaries
+    for(const auto& [l_type, l_func] : a_scope.m_nullaries)
+    {
+        term l_term{.m_body = func::body{.m_functor = l_func}};
+
+        for(size_t i = 0; i < a_data.size(); ++i)
+            l_term.m_values.push_back(l_func->m_body.eval(nullptr, 0));
+
+        if(l_add(l_type, 1, std::move(l_term)))
+            return l_split;
+    }
+
+    ////////////////////////////////////////////////////
+    //////////////// ENUMERATE LARGER SIZES ////////////
+    ////////////////////////////////////////////////////
+    for(size_t l_size = 2; l_size <= a_max_size; ++l_size)
+    {
+        for(const auto& [l_type, l_func] : a_scope.m_non_nullaries)
+        {
+            // get the arg types in order of param index
+            std::vector<std::type_index> l_arg_types(
+                l_func->m_param_types.size(), typeid(void));
+            for(const auto& [l_param_type, l_index] : l_func->m_param_types)
+                l_arg_types[l_index] = l_param_type;
+
+            std::vector<const term*> l_args(l_arg_types.size());
+            std::vector<std::any> l_arg_values(l_arg_types.size());
+
+            // apply the func to each choice of args
+            auto l_visit = [&](const std::vector<const term*>& a_args)
+            {
+                term l_term{.m_body = func::body{.m_functor = l_func}};
+
+                for(const term* l_arg : a_args)
+                    l_term.m_body.m_children.push_back(l_arg->m_body);
+
+                // evaluate on each data point from the args' values
+                for(size_t i = 0; i < a_data.size(); ++i)
+                {
+                    for(size_t j = 0; j < a_args.size(); ++j)
+                        l_arg_values[j] = a_args[j]->m_values[i];
+
+                    l_term.m_values.push_back(l_func->m_body.eval(
+                        l_arg_values.data(), l_arg_values.size()));
+                }
+
+                return l_add(l_type, l_size, std::move(l_term));
+            };
+
+            // the func itself takes one node
+            if(combine_args(l_bank, l_func, l_arg_types, 0, l_size - 1,
+                            l_args, l_visit))
+                return l_split;
+        }
+    }
+
+    return l_split;
+}
+
+model enumerate_model(
+    program& a_program, const scope& a_scope,
+    const std::multimap<std::type_index, size_t>& a_param_types,
+    const std::vector<std::pair<std::vector<std::any>, bool>>& a_data,
+    const size_t& a_max_size)
+{
+    ////////////////////////////////////////////////////
+    //////////////// CHECK FOR TRIVIALITY //////////////
+    ////////////////////////////////////////////////////
+    if(a_data.empty())
+        throw std::runtime_error("Error: no data points to build model from.");
+
+    ////////////////////////////////////////////////////
+    //////////////// CHECK FOR HOMOGENEITY /////////////
+    ////////////////////////////////////////////////////
+    bool l_homogenous_value = a_data.begin()->second;
+
+    bool l_data_is_homogenous =
+        std::all_of(a_data.begin(), a_data.end(),
+                    [l_homogenous_value](const auto& a_data_point)
+                    { return a_data_point.second == l_homogenous_value; });
+
+    if(l_data_is_homogenous)
+        return model{.m_homogenous_value = l_homogenous_value};
+
+    ////////////////////////////////////////////////////
+    ////////////// ENUMERATE BINNING FUNCTION //////////
+    ////////////////////////////////////////////////////
+    std::optional<func::body> l_binning_function_body =
+        enumerate_binning_function(a_scope, a_param_types, a_data,
+                                   a_max_size);
+
+    if(!l_binning_function_body.has_value())
+        throw std::runtime_error(
+            "Error: no binning function within the size limit.");
+
+    std::vector<std::pair<std::vector<std::any>, bool>> l_negative_bin;
+    std::vector<std::pair<std::vector<std::any>, bool>> l_positive_bin;
+
+    for(const auto& [l_x, l_y] : a_data)
+    {
+        bool l_binning_result = std::any_cast<bool>(
+            l_binning_function_body->eval(l_x.data(), l_x.size()));
+
+        if(l_binning_result)
+            l_positive_bin.emplace_back(l_x, l_y);
+        else
+            l_negative_bin.emplace_back(l_x, l_y);
+    }
+
+    // construct the function definition
+    auto l_binning_function = std::make_shared<func>(
+        typeid(bool), a_param_types, *l_binning_function_body,
+        l_binning_function_body->repr());
+
+    // add the binning function to the program
+    a_program.m_funcs.push_back(l_binning_function);
+
+    ////////////////////////////////////////////////////
+    //////////////////////// RECUR /////////////////////
+    ////////////////////////////////////////////////////
+    model l_negative_child = enumerate_model(
+        a_program, a_scope, a_param_types, l_negative_bin, a_max_size);
+
+    model l_positive_child = enumerate_model(
+        a_program, a_scope, a_param_types, l_positive_bin, a_max_size);
+
+    return model{
+        .m_func = l_binning_function.get(),
+        .m_negative_child = std::make_shared<model>(l_negative_child),
+        .m_positive_child = std::make_shared<model>(l_positive_child),
+    };
+}
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+
+void test_enumerate_binning_function()
+{
+    // learn x^2 < y
+    {
+        std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+            {{0, 0}, false},  {{0, 1}, true},  {{0, 2}, true},
+            {{1, 0}, false},  {{1, 2}, true},  {{2, 3}, false},
+            {{2, 4}, false},  {{2, 5}, true},  {{7, 49}, false},
+            {{7, 50}, true},
+        };
+
+        program l_program;
+        scope l_scope;
+
+        l_scope.add_function(
+            l_program.add_primitive("0", std::function([]() { return 0; })));
+        l_scope.add_function(l_program.add_primitive(
+            "succ", std::function([](int a_n) { return a_n + 1; })));
+        l_scope.add_function(l_program.add_primitive(
+            "square", std::function([](int a_n) { return a_n * a_n; })));
+        l_scope.add_function(l_program.add_primitive(
+            ">", std::function([](int a_x, int a_y) { return a_x > a_y; })));
+        l_scope.add_function(l_program.add_primitive(
+            "<", std::function([](int a_x, int a_y) { return a_x < a_y; })));
+
+        std::multimap<std::type_index, size_t> l_param_types{
+            {typeid(int), 0}, {typeid(int), 1}};
+
+        auto l_body = enumerate_binning_function(l_scope, l_param_types,
+                                                 l_data, 6);
+
+        // the minimal separating function is e.g. <(square(?0),?1)
+        assert(l_body.has_value());
+        assert(l_body->node_count() == 4);
+        for(const auto& [l_x, l_y] : l_data)
+            assert(std::any_cast<bool>(l_body->eval(l_x.data(),
+                                                    l_x.size())) == l_y);
+
+        // too small a size limit gives only a non-degenerate split
+        auto l_split = enumerate_binning_function(l_scope, l_param_types,
+                                                  l_data, 3);
+        assert(l_split.has_value());
+        assert(l_split->node_count() == 3);
+
+        // and no terms at all give nothing
+        assert(!enumerate_binning_function(l_scope, l_param_types, l_data, 0)
+                    .has_value());
+    }
+
+    // data which no term of type bool can split
+    {
+        std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+            {{1}, false},
+            {{2}, true},
+        };
+
+        scope l_scope;
+        std::multimap<std::type_index, size_t> l_param_types{
+            {typeid(int), 0}};
+
+        assert(!enumerate_binning_function(l_scope, l_param_types, l_data, 8)
+                    .has_value());
+    }
+}
+
+void test_enumerate_canonical()
+{
+    // learn x + y + z > 6, where + is commutative and associative
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{0, 0, 0}, false}, {{1, 2, 3}, false}, {{3, 2, 1}, false},
+        {{1, 2, 4}, true},  {{4, 2, 1}, true},  {{7, 0, 0}, true},
+        {{0, 0, 7}, true},  {{6, 0, 0}, false}, {{2, 2, 2}, false},
+        {{2, 3, 2}, true},
+    };
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(
+        l_program.add_primitive("6", std::function([]() { return 6; })));
+    l_scope.add_function(l_program.add_primitive(
+        "+", std::function([](int a_x, int a_y) { return a_x + a_y; }),
+        {.m_commutative = true, .m_associative = true}));
+    l_scope.add_function(l_program.add_primitive(
+        ">", std::function([](int a_x, int a_y) { return a_x > a_y; })));
+
+    std::multimap<std::type_index, size_t> l_param_types{
+        {typeid(int), 0}, {typeid(int), 1}, {typeid(int), 2}};
+
+    auto l_body =
+        enumerate_binning_function(l_scope, l_param_types, l_data, 7);
+
+    // the sum is found, nested to the right
+    assert(l_body.has_value());
+    assert(l_body->node_count() == 7);
+    assert(l_body->repr().find("+(+(") == std::string::npos);
+    for(const auto& [l_x, l_y] : l_data)
+        assert(std::any_cast<bool>(l_body->eval(l_x.data(), l_x.size())) ==
+               l_y);
+}
+
+void test_enumerate_model()
+{
+    // learn x > 0 && x < 3
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{-3}, false}, {{-2}, false}, {{-1}, false}, {{0}, false},
+        {{1}, true},   {{2}, true},   {{3}, false},  {{4}, false},
+        {{5}, false},  {{6}, false},
+    };
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(
+        l_program.add_primitive("0", std::function([]() { return 0; })));
+    l_scope.add_function(l_program.add_primitive(
+        "succ", std::function([](int a_n) { return a_n + 1; })));
+    l_scope.add_function(l_program.add_primitive(
+        ">", std::function([](int a_x, int a_y) { return a_x > a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "<", std::function([](int a_x, int a_y) { return a_x < a_y; })));
+
+    size_t l_primitive_count = l_program.m_funcs.size();
+
+    model l_model = enumerate_model(l_program, l_scope, {{typeid(int), 0}},
+                                    l_data, 6);
+
+    // no single comparison separates the data, so there are two bins
+    assert(l_model.node_count() == 5);
+    assert(l_program.m_funcs.size() == l_primitive_count + 2);
+
+    // the model fits the data
+    for(const auto& [l_x, l_y] : l_data)
+        assert(l_model.eval(l_x.data(), l_x.size()) == l_y);
+
+    // no data
+    assert_throws(enumerate_model(l_program, l_scope, {{typeid(int), 0}}, {},
+                                  6),
+                  std::runtime_error);
+}
+
+void enumerate_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_enumerate_binning_function);
+    TEST(test_enumerate_canonical);
+    TEST(test_enumerate_model);
+}
+
+#endif
@@ -35,6 +35,40 @@ size_t func::body::node_count() const
                            { return a_sum + a_child.node_count(); });
 }
 
+double func::body::cost() const
+{
+    double l_result = 1;
+
+    if(const auto* l_func = std::get_if<const func*>(&m_functor))
+        l_result = (*l_func)->cost();
+
+    return std::accumulate(m_children.begin(), m_children.end(), l_result,
+                           [](double a_sum, const body& a_child)
+                           { return a_sum + a_child.cost(); });
+}
+
+std::string func::body::repr() const
+{
+    // if this holds a parameter, represent it by index
+    if(const auto* l_param = std::get_if<param>(&m_functor))
+        return "?" + std::to_string(l_param->m_index);
+
+    // primitives are anonymous, funcs are represented by name
+    std::string l_result = "primitive(";
+    if(const auto* l_func = std::get_if<const func*>(&m_functor))
+        l_result = (*l_func)->m_repr + "(";
+
+    // represent all children
+    for(size_t i = 0; i < m_children.size(); ++i)
+    {
+        if(i > 0)
+            l_result += ",";
+        l_result += m_children[i].repr();
+    }
+
+    return l_result + ")";
+}
+
 func::func(const std::type_index& a_return_type,
            const std::multimap<std::type_index, size_t>& a_param_types,
            const body& a_body, const std::string& a_repr)
@@ -43,8 +77,18 @@ func::func(const std::type_index& a_return_type,
 {
 }
 
+double func::cost() const
+{
+    // a primitive's body only holds placeholders for its args
+    if(std::holds_alternative<primitive>(m_body.m_functor))
+        return m_properties.m_cost;
+
+    return m_body.cost();
+}
+
 #ifdef UNIT_TEST
 
+#include "../include/program.hpp"
 #include "test_utils.hpp"
 
 void test_func_construction()
@@ -254,6 +298,83 @@ void test_func_body_node_count()
     }
 }
 
+void test_func_body_repr()
+{
+    func l_exor(typeid(bool), {}, func::body{}, "exor");
+
+    // param
+    {
+        func::body l_node{.m_functor = func::param{3}};
+        assert(l_node.repr() == "?3");
+    }
+
+    // nullary func
+    {
+        func::body l_node{.m_functor = &l_exor};
+        assert(l_node.repr() == "exor()");
+    }
+
+    // nested funcs
+    {
+        func::body l_node{
+            .m_functor = &l_exor,
+            .m_children =
+                {
+                    func::body{.m_functor = func::param{0}},
+                    func::body{
+                        .m_functor = &l_exor,
+                        .m_children =
+                            {
+                                func::body{.m_functor = func::param{1}},
+                                func::body{.m_functor = func::param{2}},
+                            },
+                    },
+                },
+        };
+        assert(l_node.repr() == "exor(?0,exor(?1,?2))");
+    }
+}
+
+void test_func_cost()
+{
+    program l_program;
+
+    auto l_succ = l_program.add_primitive(
+        "succ", std::function([](int a_x) { return a_x + 1; }));
+    auto l_length = l_program.add_primitive(
+        "length", std::function([](std::string a_x) { return a_x.size(); }),
+        {.m_cost = 10});
+
+    // a primitive costs what was declared, not counting its args
+    assert(l_succ->cost() == 1);
+    assert(l_length->cost() == 10);
+
+    // succ(length(?0)), where the param costs 1
+    func::body l_body{
+        .m_functor = l_succ,
+        .m_children = {func::body{
+            .m_functor = l_length,
+            .m_children = {func::body{.m_functor = func::param{0}}},
+        }},
+    };
+    assert(l_body.cost() == 12);
+
+    // with default costs, the cost is the node count
+    func::body l_default_body{
+        .m_functor = l_succ,
+        .m_children = {func::body{
+            .m_functor = l_succ,
+            .m_children = {func::body{.m_functor = func::param{0}}},
+        }},
+    };
+    assert(l_default_body.cost() == l_default_body.node_count());
+
+    // a func defined by a body costs its body
+    func l_func(typeid(int), {{typeid(std::string), 0}}, l_body,
+                "succ(length(?0))");
+    assert(l_func.cost() == 12);
+}
+
 void func_test_main()
 {
     constexpr bool ENABLE_DEBUG_LOGS = true;
@@ -261,6 +382,70 @@ void func_test_main()
     TEST(test_func_construction);
     TEST(test_func_body_eval);
     TEST(test_func_body_node_count);
+    TEST(test_func_body_repr);
+    TEST(test_func_cost);
+}
+
+#endif
+
+#ifdef BENCHMARK
+
+#include "bench_utils.hpp"
+
+// construct a full tree of sums with the given arity and depth, whose
+// leaves are all the first param
+func::body make_sum_tree(size_t a_arity, size_t a_depth)
+{
+    if(a_depth == 0)
+        return func::body{.m_functor = func::param{0}};
+
+    func::body l_node{
+        .m_functor =
+            func::primitive{
+                [](const std::any* a_params, size_t a_param_count)
+                {
+                    int l_sum = 0;
+                    for(size_t i = 0; i < a_param_count; ++i)
+                        l_sum += std::any_cast<int>(a_params[i]);
+                    return std::any(l_sum);
+                },
+            },
+    };
+
+    for(size_t i = 0; i < a_arity; ++i)
+        l_node.m_children.push_back(make_sum_tree(a_arity, a_depth - 1));
+
+    return l_node;
+}
+
+void bench_func_body_eval()
+{
+    std::vector<std::any> l_input{std::any(1)};
+
+    for(size_t l_arity : {1, 2, 3})
+    {
+        for(size_t l_depth : {1, 2, 4, 6})
+        {
+            func::body l_body = make_sum_tree(l_arity, l_depth);
+
+            bench("func::body::eval",
+                  {
+                      {"arity", l_arity},
+                      {"depth", l_depth},
+                      {"node_count", l_body.node_count()},
+                  },
+                  [&]()
+                  {
+                      do_not_optimize(
+                          l_body.eval(l_input.data(), l_input.size()));
+                  });
+        }
+    }
+}
+
+void func_bench_main()
+{
+    BENCH(bench_func_body_eval);
 }
 
 #endif
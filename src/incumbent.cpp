@@ -0,0 +1,103 @@
+#include "../include/incumbent.hpp"
+#include <limits>
+
+incumbent::incumbent(const std::chrono::steady_clock::time_point& a_deadline,
+                     const double& a_target_reward)
+    : m_reward(-std::numeric_limits<double>::infinity()),
+      m_deadline(a_deadline), m_target_reward(a_target_reward)
+{
+}
+
+bool incumbent::offer(const double& a_reward, const program& a_program,
+                      const model& a_model)
+{
+    // REASON: most offers lose, so reject them without locking
+    if(a_reward <= m_reward.load())
+        return false;
+
+    std::lock_guard<std::mutex> l_lock(m_mutex);
+
+    // check again, another search may have improved it meanwhile
+    if(a_reward <= m_reward.load())
+        return false;
+
+    m_program = a_program;
+    m_model = a_model;
+    m_reward.store(a_reward);
+
+    return true;
+}
+
+bool incumbent::should_stop() const
+{
+    return m_reward.load() >= m_target_reward ||
+           std::chrono::steady_clock::now() >= m_deadline;
+}
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+
+void test_incumbent_offer()
+{
+    incumbent l_incumbent(std::chrono::steady_clock::time_point::max(),
+                          std::numeric_limits<double>::infinity());
+
+    assert(l_incumbent.m_reward.load() ==
+           -std::numeric_limits<double>::infinity());
+
+    // the first offer is always kept
+    assert(l_incumbent.offer(-10, program{},
+                             model{.m_homogenous_value = true}));
+    assert(l_incumbent.m_reward.load() == -10);
+    assert(l_incumbent.m_model.m_homogenous_value == true);
+
+    // worse and equal offers are rejected
+    assert(!l_incumbent.offer(-11, program{},
+                              model{.m_homogenous_value = false}));
+    assert(!l_incumbent.offer(-10, program{},
+                              model{.m_homogenous_value = false}));
+    assert(l_incumbent.m_model.m_homogenous_value == true);
+
+    // better offers are kept, along with their program
+    program l_program;
+    l_program.add_primitive("f0", std::function([]() { return 0; }));
+    assert(l_incumbent.offer(-5, l_program,
+                             model{.m_homogenous_value = false}));
+    assert(l_incumbent.m_reward.load() == -5);
+    assert(l_incumbent.m_program.m_funcs.size() == 1);
+    assert(l_incumbent.m_model.m_homogenous_value == false);
+}
+
+void test_incumbent_should_stop()
+{
+    // neither deadline nor target reached
+    {
+        incumbent l_incumbent(std::chrono::steady_clock::time_point::max(),
+                              -3);
+        assert(!l_incumbent.should_stop());
+        l_incumbent.offer(-4, program{}, model{});
+        assert(!l_incumbent.should_stop());
+
+        // target reached
+        l_incumbent.offer(-3, program{}, model{});
+        assert(l_incumbent.should_stop());
+    }
+
+    // deadline passed
+    {
+        incumbent l_incumbent(std::chrono::steady_clock::now(),
+                              std::numeric_limits<double>::infinity());
+        assert(l_incumbent.should_stop());
+    }
+}
+
+void incumbent_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_incumbent_offer);
+    TEST(test_incumbent_should_stop);
+}
+
+#endif
@@ -0,0 +1,271 @@
+#include "../include/intern.hpp"
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+
+string_pool::string_pool()
+{
+    static std::atomic<uint64_t> s_generation_count{0};
+    m_generation = s_generation_count++;
+}
+
+interned_string string_pool::intern(std::string_view a_string)
+{
+    auto l_entry = m_ids.find(a_string);
+
+    if(l_entry != m_ids.end())
+        return at(l_entry->second);
+
+    if(m_entries.size() > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Error: too many distinct strings.");
+
+    uint32_t l_id = m_entries.size();
+    m_entries.push_back({
+        .m_string = std::string(a_string),
+        .m_pool = this,
+        .m_id = l_id,
+    });
+    m_ids.emplace(m_entries.back().m_string, l_id);
+
+    return at(l_id);
+}
+
+interned_string string_pool::at(uint32_t a_id) const
+{
+    return interned_string{.m_entry = &m_entries.at(a_id)};
+}
+
+size_t string_pool::size() const
+{
+    return m_entries.size();
+}
+
+#ifdef UNIT_TEST
+
+#include "../include/reduce.hpp"
+#include "test_utils.hpp"
+#include <optional>
+
+void test_string_pool()
+{
+    string_pool l_pool;
+
+    interned_string l_apple = l_pool.intern("apple");
+    interned_string l_pear = l_pool.intern("pear");
+
+    assert(l_apple.id() == 0);
+    assert(l_pear.id() == 1);
+    assert(l_apple.view() == "apple");
+    assert(l_pear.size() == 4);
+    assert(l_pool.size() == 2);
+
+    // equal strings share a handle
+    interned_string l_apple_again = l_pool.intern(std::string("apple"));
+    assert(l_apple_again.id() == 0);
+    assert(l_apple_again.m_entry == l_apple.m_entry);
+    assert(l_apple_again == l_apple);
+    assert(!(l_apple == l_pear));
+    assert(l_apple < l_pear);
+    assert(l_pool.size() == 2);
+
+    // handles stay valid as the pool grows
+    for(int i = 0; i < 10000; ++i)
+        l_pool.intern("string " + std::to_string(i));
+
+    assert(l_pool.size() == 10002);
+    assert(l_apple.view() == "apple");
+    assert(l_pool.intern("apple").m_entry == l_apple.m_entry);
+    assert(l_pool.at(1).m_entry == l_pear.m_entry);
+    assert(l_pool.at(5000).view() == "string 4998");
+
+    // handles of equal strings of different pools are equal
+    string_pool l_other_pool;
+    assert(l_other_pool.intern("apple") == l_apple);
+
+    // an empty handle is an empty string, equal to an interned one
+    assert(interned_string{}.view().empty());
+    assert(interned_string{} == l_other_pool.intern(""));
+    assert(!(interned_string{} == l_apple));
+
+    // a handle is stored inline in an any
+    static_assert(sizeof(interned_string) == sizeof(void*));
+}
+
+void test_memoize_interned()
+{
+    size_t l_calls = 0;
+
+    auto l_length = memoize_interned(std::function(
+        [&l_calls](std::string_view a_string)
+        {
+            ++l_calls;
+            return int(a_string.size());
+        }));
+
+    string_pool l_pool;
+
+    // each distinct string is measured once
+    for(int i = 0; i < 100; ++i)
+        assert(l_length(l_pool.intern(i % 2 ? "odd" : "even")) ==
+               (i % 2 ? 3 : 4));
+
+    assert(l_calls == 2);
+
+    // another pool has its own ids
+    string_pool l_other_pool;
+    l_other_pool.intern("a longer string");
+    assert(l_length(l_other_pool.intern("a longer string")) == 15);
+    assert(l_calls == 3);
+
+    // alternating between pools keeps the results of both
+    for(int i = 0; i < 10; ++i)
+    {
+        assert(l_length(l_pool.intern("odd")) == 3);
+        assert(l_length(l_other_pool.intern("a longer string")) == 15);
+    }
+
+    assert(l_calls == 3);
+
+    // a pool made where a destroyed one was does not see its results
+    std::optional<string_pool> l_reused_pool;
+    l_reused_pool.emplace();
+    const string_pool* l_address = &*l_reused_pool;
+    assert(l_length(l_reused_pool->intern("first")) == 5);
+
+    l_reused_pool.emplace();
+    assert(&*l_reused_pool == l_address);
+    assert(l_length(l_reused_pool->intern("second")) == 6);
+    assert(l_calls == 5);
+
+    // an empty handle is measured as an empty string
+    assert(l_length(interned_string{}) == 0);
+}
+
+void test_learn_model_interned()
+{
+    // learn string length < 5, from many rows of few strings
+    const std::vector<std::string> STRINGS{"a", "bb", "ccc", "dddd",
+                                           "eeeee", "ffffff", "ggggggg"};
+
+    string_pool l_pool;
+    typed_dataset<interned_string> l_data;
+
+    for(size_t i = 0; i < 700; ++i)
+    {
+        const std::string& l_string = STRINGS[i % STRINGS.size()];
+        std::get<0>(l_data.m_columns).push_back(l_pool.intern(l_string));
+        l_data.m_labels.push_back(l_string.size() < 5);
+    }
+
+    size_t l_calls = 0;
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "string_length", memoize_interned(std::function(
+                             [&l_calls](std::string_view a_string)
+                             {
+                                 ++l_calls;
+                                 return int(a_string.size());
+                             }))));
+    l_scope.add_function(l_program.add_primitive(
+        "less_than",
+        std::function([](int a_x, int a_y) { return a_x < a_y; })));
+    l_scope.add_function(
+        l_program.add_primitive("5", std::function([]() { return 5; })));
+
+    model l_model = learn_model(
+        l_program, l_scope, l_data,
+        search_config{.m_iterations = 2000,
+                      .m_recursion_limit = 3,
+                      .m_exploration_constant = 10});
+
+    // the model separates the data
+    std::any l_param;
+    for(size_t i = 0; i < l_data.size(); ++i)
+    {
+        l_data.fill_row(i, &l_param);
+        assert(l_model.eval(&l_param, 1) == l_data.m_labels[i]);
+    }
+
+    // and the length of each distinct string was measured once
+    assert(l_calls <= STRINGS.size());
+}
+
+void intern_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_string_pool);
+    TEST(test_memoize_interned);
+    TEST(test_learn_model_interned);
+}
+
+#endif
+
+#ifdef BENCHMARK
+
+#include "../include/program.hpp"
+#include "bench_utils.hpp"
+#include <any>
+
+void bench_interned_eval()
+{
+    constexpr size_t ROW_COUNT = 100000;
+    constexpr size_t DISTINCT_COUNT = 20;
+
+    // few distinct long strings, as in logs
+    std::vector<std::string> l_strings;
+    for(size_t i = 0; i < DISTINCT_COUNT; ++i)
+        l_strings.push_back(std::string(200 + i, 'x'));
+
+    string_pool l_pool;
+    std::vector<std::any> l_plain_rows;
+    std::vector<std::any> l_interned_rows;
+
+    for(size_t i = 0; i < ROW_COUNT; ++i)
+    {
+        l_plain_rows.emplace_back(l_strings[i % DISTINCT_COUNT]);
+        l_interned_rows.emplace_back(
+            l_pool.intern(l_strings[i % DISTINCT_COUNT]));
+    }
+
+    // the vowel count of a string, a pure function worth caching
+    auto l_vowels = [](std::string_view a_string)
+    {
+        int l_count = 0;
+        for(char l_char : a_string)
+            l_count += l_char == 'a' || l_char == 'e' || l_char == 'i' ||
+                       l_char == 'o' || l_char == 'u';
+        return l_count;
+    };
+
+    program l_program;
+    const func* l_plain = l_program.add_primitive(
+        "vowels", std::function([l_vowels](std::string a_string)
+                                { return l_vowels(a_string); }));
+    const func* l_interned = l_program.add_primitive(
+        "vowels", memoize_interned(std::function(l_vowels)));
+
+    bench("eval_string_primitive", {{"row_count", ROW_COUNT}, {"interned", 0}},
+          [&]()
+          {
+              for(const std::any& l_row : l_plain_rows)
+                  do_not_optimize(l_plain->m_body.eval(&l_row, 1));
+          });
+
+    bench("eval_string_primitive", {{"row_count", ROW_COUNT}, {"interned", 1}},
+          [&]()
+          {
+              for(const std::any& l_row : l_interned_rows)
+                  do_not_optimize(l_interned->m_body.eval(&l_row, 1));
+          });
+}
+
+void intern_bench_main()
+{
+    BENCH(bench_interned_eval);
+}
+
+#endif // BENCHMARK
@@ -1,3 +1,5 @@
+#ifdef UNIT_TEST
+
 #include "test_utils.hpp"
 
 extern void scope_test_main();
@@ -5,6 +7,20 @@ extern void func_test_main();
 extern void program_test_main();
 extern void model_test_main();
 extern void reduce_test_main();
+extern void truth_table_test_main();
+extern void bdd_test_main();
+extern void minimize_test_main();
+extern void enumerate_test_main();
+extern void incumbent_test_main();
+extern void portfolio_test_main();
+extern void search_stats_test_main();
+extern void profile_test_main();
+extern void trace_test_main();
+extern void search_tree_test_main();
+extern void checkpoint_test_main();
+extern void dataset_test_main();
+extern void intern_test_main();
+extern void duplicates_test_main();
 
 void unit_test_main()
 {
@@ -15,11 +31,60 @@ void unit_test_main()
     TEST(program_test_main);
     TEST(model_test_main);
     TEST(reduce_test_main);
+    TEST(truth_table_test_main);
+    TEST(bdd_test_main);
+    TEST(minimize_test_main);
+    TEST(enumerate_test_main);
+    TEST(incumbent_test_main);
+    TEST(portfolio_test_main);
+    TEST(search_stats_test_main);
+    TEST(profile_test_main);
+    TEST(trace_test_main);
+    TEST(search_tree_test_main);
+    TEST(checkpoint_test_main);
+    TEST(dataset_test_main);
+    TEST(intern_test_main);
+    TEST(duplicates_test_main);
 }
 
+#endif
+
+#ifdef BENCHMARK
+
+#include "bench_utils.hpp"
+
+extern void func_bench_main();
+extern void program_bench_main();
+extern void model_bench_main();
+extern void reduce_bench_main();
+extern void dataset_bench_main();
+extern void intern_bench_main();
+extern void duplicates_bench_main();
+
+void bench_main()
+{
+    BENCH(func_bench_main);
+    BENCH(program_bench_main);
+    BENCH(model_bench_main);
+    BENCH(reduce_bench_main);
+    BENCH(dataset_bench_main);
+    BENCH(intern_bench_main);
+    BENCH(duplicates_bench_main);
+
+    write_bench_results(std::cout);
+}
+
+#endif
+
 int main()
 {
+#ifdef UNIT_TEST
     unit_test_main();
+#endif
+
+#ifdef BENCHMARK
+    bench_main();
+#endif
 
     return 0;
 }
@@ -0,0 +1,288 @@
+#include "../include/minimize.hpp"
+#include "../include/truth_table.hpp"
+#include <algorithm>
+#include <bit>
+#include <set>
+#include <stdexcept>
+
+bool cube::covers(uint64_t a_key) const
+{
+    return (a_key & m_care) == m_value;
+}
+
+std::vector<cube>
+minimize_sop(const std::vector<std::pair<std::vector<std::any>, bool>>& a_data)
+{
+    ////////////////////////////////////////////////////
+    ///////////////// SPLIT THE ROW KEYS ///////////////
+    ////////////////////////////////////////////////////
+    size_t l_param_count = a_data.empty() ? 0 : a_data.front().first.size();
+
+    if(l_param_count > 64)
+        throw std::runtime_error("Error: too many params to minimize.");
+
+    std::set<uint64_t> l_on_set;
+    std::set<uint64_t> l_off_set;
+
+    for(const auto& [l_x, l_y] : a_data)
+    {
+        uint64_t l_key = truth_table::key(l_x.data(), l_x.size());
+        (l_y ? l_on_set : l_off_set).insert(l_key);
+    }
+
+    // REASON: no function can separate identical inputs
+    for(uint64_t l_key : l_on_set)
+        if(l_off_set.contains(l_key))
+            throw std::runtime_error("Error: conflicting data points.");
+
+    ////////////////////////////////////////////////////
+    /////////////////////// EXPAND /////////////////////
+    ////////////////////////////////////////////////////
+
+    // check if a cube avoids every false row
+    auto l_is_implicant = [&l_off_set](const cube& a_cube)
+    {
+        return std::none_of(l_off_set.begin(), l_off_set.end(),
+                            [&a_cube](uint64_t a_key)
+                            { return a_cube.covers(a_key); });
+    };
+
+    const uint64_t l_all_params =
+        l_param_count == 64 ? ~uint64_t{0}
+                            : (uint64_t{1} << l_param_count) - 1;
+
+    // expand each true row into prime implicants by dropping literals
+    // for as long as no false row is covered. starting the drops from
+    // each param in turn gives a choice of primes for the cover.
+    std::set<std::pair<uint64_t, uint64_t>> l_primes;
+
+    for(uint64_t l_key : l_on_set)
+    {
+        for(size_t l_start = 0; l_start < std::max<size_t>(l_param_count, 1);
+            ++l_start)
+        {
+            cube l_cube{l_all_params, l_key};
+
+            for(size_t j = 0; j < l_param_count; ++j)
+            {
+                uint64_t l_bit = uint64_t{1}
+                                 << ((l_start + j) % l_param_count);
+
+                cube l_expanded{l_cube.m_care & ~l_bit,
+                                l_cube.m_value & ~l_bit};
+
+                if(l_is_implicant(l_expanded))
+                    l_cube = l_expanded;
+            }
+
+            l_primes.emplace(l_cube.m_care, l_cube.m_value);
+        }
+    }
+
+    ////////////////////////////////////////////////////
+    /////////////////////// COVER //////////////////////
+    ////////////////////////////////////////////////////
+    std::vector<cube> l_cover;
+    std::set<uint64_t> l_uncovered = l_on_set;
+
+    // greedily take the prime covering the most uncovered true rows,
+    // preferring fewer literals
+    while(!l_uncovered.empty())
+    {
+        cube l_best{};
+        size_t l_best_covered = 0;
+
+        for(const auto& [l_care, l_value] : l_primes)
+        {
+            cube l_prime{l_care, l_value};
+
+            size_t l_covered =
+                std::count_if(l_uncovered.begin(), l_uncovered.end(),
+                              [&l_prime](uint64_t a_key)
+                              { return l_prime.covers(a_key); });
+
+            if(l_covered > l_best_covered ||
+               (l_covered == l_best_covered && l_covered > 0 &&
+                std::popcount(l_care) < std::popcount(l_best.m_care)))
+            {
+                l_best = l_prime;
+                l_best_covered = l_covered;
+            }
+        }
+
+        std::erase_if(l_uncovered, [&l_best](uint64_t a_key)
+                      { return l_best.covers(a_key); });
+
+        l_cover.push_back(l_best);
+    }
+
+    return l_cover;
+}
+
+std::shared_ptr<func> make_sop_function(const std::vector<cube>& a_cover,
+                                        size_t a_param_count,
+                                        const func* a_and, const func* a_or,
+                                        const func* a_not)
+{
+    if(a_param_count == 0)
+        throw std::runtime_error("Error: no params to build function from.");
+
+    // construct a literal ?i or not(?i)
+    auto l_literal = [a_not](size_t a_index, bool a_value)
+    {
+        func::body l_param{.m_functor = func::param{a_index}};
+
+        if(a_value)
+            return l_param;
+
+        return func::body{.m_functor = a_not, .m_children = {l_param}};
+    };
+
+    // combine two bodies with a binary primitive
+    auto l_combine = [](const func* a_op, const func::body& a_lhs,
+                        const func::body& a_rhs)
+    { return func::body{.m_functor = a_op, .m_children = {a_lhs, a_rhs}}; };
+
+    // REASON: without constants, false is ?0 && !?0
+    func::body l_sum =
+        l_combine(a_and, l_literal(0, true), l_literal(0, false));
+
+    for(size_t i = 0; i < a_cover.size(); ++i)
+    {
+        const cube& l_cube = a_cover[i];
+
+        // REASON: without constants, true is ?0 || !?0
+        func::body l_product =
+            l_combine(a_or, l_literal(0, true), l_literal(0, false));
+
+        // multiply the literals
+        bool l_first = true;
+        for(size_t j = 0; j < a_param_count; ++j)
+        {
+            if(!((l_cube.m_care >> j) & 1))
+                continue;
+
+            func::body l_factor = l_literal(j, (l_cube.m_value >> j) & 1);
+
+            l_product =
+                l_first ? l_factor : l_combine(a_and, l_product, l_factor);
+            l_first = false;
+        }
+
+        // sum the products
+        l_sum = i == 0 ? l_product : l_combine(a_or, l_sum, l_product);
+    }
+
+    // the binning function takes all of the bool params
+    std::multimap<std::type_index, size_t> l_param_types;
+    for(size_t i = 0; i < a_param_count; ++i)
+        l_param_types.emplace(typeid(bool), i);
+
+    return std::make_shared<func>(typeid(bool), l_param_types, l_sum,
+                                  l_sum.repr());
+}
+
+#ifdef UNIT_TEST
+
+#include "../include/program.hpp"
+#include "test_utils.hpp"
+
+void test_minimize_sop()
+{
+    // a && b, with the a && !b row missing
+    {
+        std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+            {{false, false}, false},
+            {{false, true}, false},
+            {{true, true}, true},
+        };
+
+        auto l_cover = minimize_sop(l_data);
+
+        // the missing row lets the product shrink to just a
+        assert(l_cover.size() == 1);
+        assert(l_cover[0].m_care == 0b01);
+        assert(l_cover[0].m_value == 0b01);
+    }
+
+    // a || b needs two products
+    {
+        std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+            {{false, false}, false},
+            {{false, true}, true},
+            {{true, false}, true},
+            {{true, true}, true},
+        };
+
+        auto l_cover = minimize_sop(l_data);
+        assert(l_cover.size() == 2);
+        for(const cube& l_cube : l_cover)
+            assert(std::popcount(l_cube.m_care) == 1);
+    }
+
+    // no true rows
+    {
+        std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+            {{false}, false},
+        };
+        assert(minimize_sop(l_data).empty());
+    }
+
+    // conflicting rows
+    {
+        std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+            {{false, true}, false},
+            {{false, true}, true},
+        };
+        assert_throws(minimize_sop(l_data), std::runtime_error);
+    }
+}
+
+void test_make_sop_function()
+{
+    program l_program;
+
+    auto l_and = l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; }));
+    auto l_or = l_program.add_primitive(
+        "or", std::function([](bool a_x, bool a_y) { return a_x || a_y; }));
+    auto l_not = l_program.add_primitive(
+        "not", std::function([](bool a_x) { return !a_x; }));
+
+    // nested exor, with the (1, 0, 1) row missing
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{false, false, false}, false}, {{false, false, true}, true},
+        {{false, true, false}, true},   {{false, true, true}, false},
+        {{true, false, false}, true},   {{true, true, false}, false},
+        {{true, true, true}, true},
+    };
+
+    auto l_cover = minimize_sop(l_data);
+    auto l_func = make_sop_function(l_cover, 3, l_and, l_or, l_not);
+
+    assert(l_func->m_return_type == typeid(bool));
+    assert(l_func->m_param_types.size() == 3);
+
+    // the function separates the data
+    for(const auto& [l_x, l_y] : l_data)
+        assert(std::any_cast<bool>(l_func->m_body.eval(l_x.data(),
+                                                       l_x.size())) == l_y);
+
+    // the repr is in the form of build_function
+    {
+        std::vector<cube> l_single{cube{0b101, 0b001}};
+        auto l_product = make_sop_function(l_single, 3, l_and, l_or, l_not);
+        assert(l_product->m_repr == "and(?0,not(?2))");
+        assert(l_product->m_body.node_count() == 4);
+    }
+}
+
+void minimize_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_minimize_sop);
+    TEST(test_make_sop_function);
+}
+
+#endif
@@ -1,8 +1,9 @@
 #include "../include/model.hpp"
 #include "../include/program.hpp"
+#include <algorithm>
 #include <cassert>
 
-bool model::eval(const std::any* a_params, size_t a_param_count)
+bool model::eval(const std::any* a_params, size_t a_param_count) const
 {
     // if the model is homogenous, then return the homogenous value
     if(m_func == nullptr)
@@ -13,7 +14,7 @@ bool model::eval(const std::any* a_params, size_t a_param_count)
         std::any_cast<bool>(m_func->m_body.eval(a_params, a_param_count));
 
     // get the appropriate child
-    model* l_child =
+    const model* l_child =
         l_binning_result ? m_positive_child.get() : m_negative_child.get();
 
     return l_child->eval(a_params, a_param_count);
@@ -32,6 +33,36 @@ size_t model::node_count() const
     return l_result;
 }
 
+size_t model::depth() const
+{
+    if(m_func == nullptr)
+        return 0;
+
+    return 1 + std::max(m_negative_child->depth(), m_positive_child->depth());
+}
+
+size_t model::error_count() const
+{
+    if(m_func == nullptr)
+        return m_error_count;
+
+    return m_negative_child->error_count() + m_positive_child->error_count();
+}
+
+double model::cost(const std::any* a_params, size_t a_param_count) const
+{
+    if(m_func == nullptr)
+        return 1;
+
+    bool l_binning_result =
+        std::any_cast<bool>(m_func->m_body.eval(a_params, a_param_count));
+
+    const model* l_child =
+        l_binning_result ? m_positive_child.get() : m_negative_child.get();
+
+    return 1 + m_func->cost() + l_child->cost(a_params, a_param_count);
+}
+
 std::string model::repr() const
 {
     if(m_func == nullptr)
@@ -230,11 +261,150 @@ void test_model_eval()
     }
 }
 
+void test_model_depth()
+{
+    program l_program;
+
+    auto l_positive = l_program.add_primitive(
+        "positive", std::function([](int a_x) { return a_x > 0; }));
+
+    // homogenous
+    model l_leaf{.m_homogenous_value = true};
+    assert(l_leaf.depth() == 0);
+
+    // one binning function
+    model l_shallow{
+        .m_func = l_positive,
+        .m_negative_child = std::make_shared<model>(l_leaf),
+        .m_positive_child = std::make_shared<model>(l_leaf),
+    };
+    assert(l_shallow.depth() == 1);
+
+    // the longest path is taken, whichever child it is under
+    model l_deep{
+        .m_func = l_positive,
+        .m_negative_child = std::make_shared<model>(l_leaf),
+        .m_positive_child = std::make_shared<model>(l_shallow),
+    };
+    assert(l_deep.depth() == 2);
+}
+
+void test_model_error_count()
+{
+    program l_program;
+
+    auto l_positive = l_program.add_primitive(
+        "positive", std::function([](int a_x) { return a_x > 0; }));
+
+    // pure leaves misclassify nothing
+    model l_pure{
+        .m_func = l_positive,
+        .m_negative_child =
+            std::make_shared<model>(model{.m_homogenous_value = false}),
+        .m_positive_child =
+            std::make_shared<model>(model{.m_homogenous_value = true}),
+    };
+    assert(l_pure.error_count() == 0);
+
+    // the errors of impure leaves are summed
+    model l_impure{
+        .m_func = l_positive,
+        .m_negative_child = std::make_shared<model>(
+            model{.m_homogenous_value = false, .m_error_count = 2}),
+        .m_positive_child = std::make_shared<model>(
+            model{.m_homogenous_value = true, .m_error_count = 3}),
+    };
+    assert(l_impure.error_count() == 5);
+}
+
+void test_model_cost()
+{
+    program l_program;
+
+    auto l_positive = l_program.add_primitive(
+        "positive", std::function([](int a_x) { return a_x > 0; }),
+        {.m_cost = 5});
+    auto l_even = l_program.add_primitive(
+        "even", std::function([](int a_x) { return a_x % 2 == 0; }));
+
+    model l_leaf{.m_homogenous_value = true};
+    assert(l_leaf.cost(nullptr, 0) == 1);
+
+    // positive(x) ? (even(x) ? 1 : 1) : 1
+    model l_model{
+        .m_func = l_positive,
+        .m_negative_child = std::make_shared<model>(l_leaf),
+        .m_positive_child = std::make_shared<model>(model{
+            .m_func = l_even,
+            .m_negative_child = std::make_shared<model>(l_leaf),
+            .m_positive_child = std::make_shared<model>(l_leaf),
+        }),
+    };
+
+    // only the binning functions on the path are paid for
+    std::vector<std::any> l_negative{std::any(-1)};
+    assert(l_model.cost(l_negative.data(), l_negative.size()) == 1 + 5 + 1);
+
+    std::vector<std::any> l_positive_row{std::any(2)};
+    assert(l_model.cost(l_positive_row.data(), l_positive_row.size()) ==
+           1 + 5 + 1 + 1 + 1);
+}
+
 void model_test_main()
 {
     constexpr bool ENABLE_DEBUG_LOGS = true;
 
     TEST(test_model_eval);
+    TEST(test_model_depth);
+    TEST(test_model_error_count);
+    TEST(test_model_cost);
 }
 
 #endif // UNIT_TEST
+
+#ifdef BENCHMARK
+
+#include "bench_utils.hpp"
+
+void bench_model_eval()
+{
+    for(size_t l_depth : {1, 4, 16, 64})
+    {
+        program l_program;
+
+        // construct a chain of bins [?0 > 0] ? {[?0 > 1] ? ... : {0}} : {0}
+        model l_model{.m_homogenous_value = true};
+        for(size_t i = 0; i < l_depth; ++i)
+        {
+            int l_threshold = l_depth - i - 1;
+
+            auto l_func = l_program.add_primitive(
+                "bin", std::function([l_threshold](int a_x)
+                                     { return a_x > l_threshold; }));
+
+            l_model = model{
+                .m_func = l_func,
+                .m_negative_child =
+                    std::make_shared<model>(model{.m_homogenous_value = false}),
+                .m_positive_child = std::make_shared<model>(l_model),
+            };
+        }
+
+        // an input which reaches the deepest bin
+        std::vector<std::any> l_input{std::any(int(l_depth))};
+
+        bench("model::eval", {{"depth", l_depth}},
+              [&]()
+              {
+                  do_not_optimize(
+                      l_model.eval(l_input.data(), l_input.size()));
+              });
+    }
+}
+
+void model_bench_main()
+{
+    BENCH(bench_model_eval);
+}
+
+#endif // BENCHMARK
@@ -0,0 +1,216 @@
+#include "../include/portfolio.hpp"
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+#include <cstdio>
+#include <filesystem>
+
+void test_learn_model_portfolio()
+{
+    // learn x^2 < y
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{0, 0}, false},  {{0, 1}, true},  {{0, 2}, true},  {{1, 0}, false},
+        {{1, 2}, true},   {{2, 3}, false}, {{2, 4}, false}, {{2, 5}, true},
+        {{7, 49}, false}, {{7, 50}, true},
+    };
+
+    // initialize the program and scope
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(
+        l_program.add_primitive("0", std::function([]() { return 0; })));
+    l_scope.add_function(l_program.add_primitive(
+        "succ", std::function([](int a_n) { return a_n + 1; })));
+    l_scope.add_function(l_program.add_primitive(
+        "square", std::function([](int a_n) { return a_n * a_n; })));
+    l_scope.add_function(l_program.add_primitive(
+        ">", std::function([](int a_x, int a_y) { return a_x > a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "<", std::function([](int a_x, int a_y) { return a_x < a_y; })));
+
+    // race two exploration constants against enumeration
+    std::vector<search_config> l_configs{
+        search_config{
+            .m_iterations = 1000,
+            .m_recursion_limit = 10,
+            .m_exploration_constant = 100,
+        },
+        search_config{
+            .m_iterations = 1000,
+            .m_recursion_limit = 10,
+            .m_exploration_constant = 1000,
+            .m_seed = 28,
+        },
+        search_config{
+            .m_iterations = 1,
+            .m_recursion_limit = 10,
+            .m_exploration_constant = 0,
+            .m_enumeration_size = 6,
+        },
+    };
+
+    // with an unreachable target, every search runs to completion
+    {
+        program l_race_program = l_program;
+        scope l_race_scope = l_scope;
+
+        model l_model = learn_model_portfolio<int, int>(
+            l_race_program, l_race_scope, l_data, l_configs,
+            std::chrono::seconds(60));
+
+        // the model fits the data
+        for(const auto& [l_x, l_y] : l_data)
+            assert(l_model.eval(l_x.data(), l_x.size()) == l_y);
+
+        // enumeration finds [<(square(?0),?1)] ? {1} : {0}, which is
+        // 15 nodes of primitives, 4 of binning function and 3 of model
+        assert(model_reward(l_race_program, l_model) >= -22);
+    }
+
+    // a reachable target stops the race early
+    {
+        program l_race_program = l_program;
+        scope l_race_scope = l_scope;
+
+        model l_model = learn_model_portfolio<int, int>(
+            l_race_program, l_race_scope, l_data, l_configs,
+            std::chrono::seconds(60), -1000);
+
+        for(const auto& [l_x, l_y] : l_data)
+            assert(l_model.eval(l_x.data(), l_x.size()) == l_y);
+    }
+
+    // a trace records each search under its own thread
+    {
+        program l_race_program = l_program;
+        scope l_race_scope = l_scope;
+
+        std::vector<search_config> l_searches(l_configs.begin(),
+                                              l_configs.begin() + 2);
+        for(search_config& l_search : l_searches)
+            l_search.m_iterations = 50;
+
+        trace l_trace;
+
+        learn_model_portfolio<int, int>(
+            l_race_program, l_race_scope, l_data, l_searches,
+            std::chrono::seconds(60),
+            std::numeric_limits<double>::infinity(), &l_trace);
+
+        std::map<size_t, size_t> l_iterations_by_thread;
+        for(const trace::event& l_event : l_trace.m_events)
+            if(std::string(l_event.m_name) == "iteration")
+                ++l_iterations_by_thread[l_event.m_thread];
+
+        assert(l_iterations_by_thread ==
+               (std::map<size_t, size_t>{{0, 50}, {1, 50}}));
+    }
+
+    // with no budget, nothing is found
+    {
+        program l_race_program = l_program;
+        scope l_race_scope = l_scope;
+
+        std::vector<search_config> l_searches(l_configs.begin(),
+                                              l_configs.begin() + 2);
+
+        // REASON: parenthesized, since the template args contain a comma
+        assert_throws((learn_model_portfolio<int, int>(
+                          l_race_program, l_race_scope, l_data, l_searches,
+                          std::chrono::seconds(0))),
+                      std::runtime_error);
+    }
+
+    // other failures reach the caller rather than ending the process
+    {
+        program l_broken_program;
+        scope l_broken_scope;
+
+        l_broken_scope.add_function(l_broken_program.add_primitive(
+            "broken", std::function(
+                          [](int) -> bool
+                          { throw std::logic_error("Error: broken."); })));
+
+        std::vector<search_config> l_searches(l_configs.begin(),
+                                              l_configs.begin() + 2);
+
+        assert_throws((learn_model_portfolio<int, int>(
+                          l_broken_program, l_broken_scope, l_data,
+                          l_searches, std::chrono::seconds(60))),
+                      std::logic_error);
+    }
+
+    // data no model can separate is reported as such
+    {
+        std::vector<std::pair<std::vector<std::any>, bool>> l_conflicts =
+            l_data;
+        l_conflicts.push_back({{7, 50}, false});
+
+        program l_race_program = l_program;
+        scope l_race_scope = l_scope;
+
+        std::vector<search_config> l_searches(l_configs.begin(),
+                                              l_configs.begin() + 2);
+
+        try
+        {
+            learn_model_portfolio<int, int>(l_race_program, l_race_scope,
+                                            l_conflicts, l_searches,
+                                            std::chrono::seconds(60));
+            assert(false);
+        }
+        catch(const conflicting_rows& a_error)
+        {
+            assert(std::string(a_error.what()).find("rows 9 10.") !=
+                   std::string::npos);
+        }
+    }
+
+    // a search resumed from a checkpoint, which finds nothing better,
+    // still offers the checkpointed model
+    {
+        const std::string CHECKPOINT_PATH =
+            (std::filesystem::temp_directory_path() /
+             "test_portfolio_checkpoint")
+                .string();
+        std::remove(CHECKPOINT_PATH.c_str());
+
+        search_config l_search = l_configs.front();
+        l_search.m_iterations = 200;
+        l_search.m_checkpoint_path = CHECKPOINT_PATH;
+
+        program l_checkpointed_program = l_program;
+        scope l_checkpointed_scope = l_scope;
+        model l_checkpointed_model = learn_model<int, int>(
+            l_checkpointed_program, l_checkpointed_scope, l_data, l_search);
+
+        // REASON: the iterations are already spent, so the resumed
+        // search makes no rollouts
+        program l_race_program = l_program;
+        scope l_race_scope = l_scope;
+
+        model l_model = learn_model_portfolio<int, int>(
+            l_race_program, l_race_scope, l_data, {l_search},
+            std::chrono::seconds(60));
+
+        std::remove(CHECKPOINT_PATH.c_str());
+
+        assert(l_model.repr() == l_checkpointed_model.repr());
+        assert(model_reward(l_race_program, l_model) ==
+               model_reward(l_checkpointed_program, l_checkpointed_model));
+
+        for(const auto& [l_x, l_y] : l_data)
+            assert(l_model.eval(l_x.data(), l_x.size()) == l_y);
+    }
+}
+
+void portfolio_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_learn_model_portfolio);
+}
+
+#endif
@@ -0,0 +1,299 @@
+#include "../include/profile.hpp"
+#include "../include/program.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+void primitive_profile::record(const std::chrono::nanoseconds& a_conversion,
+                               const std::chrono::nanoseconds& a_call)
+{
+    m_calls.fetch_add(1, std::memory_order_relaxed);
+    m_conversion_ns.fetch_add(a_conversion.count(), std::memory_order_relaxed);
+    m_call_ns.fetch_add(a_call.count(), std::memory_order_relaxed);
+
+    // REASON: the bucket of a latency is the number of bits it needs
+    uint64_t l_latency = std::max<int64_t>(a_call.count(), 0);
+    size_t l_bucket = std::min<size_t>(std::bit_width(l_latency),
+                                       BUCKET_COUNT - 1);
+
+    m_latency_buckets[l_bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds
+primitive_profile::percentile(const double& a_fraction) const
+{
+    std::array<size_t, BUCKET_COUNT> l_counts;
+    for(size_t i = 0; i < BUCKET_COUNT; ++i)
+        l_counts[i] = m_latency_buckets[i].load(std::memory_order_relaxed);
+
+    size_t l_total = std::accumulate(l_counts.begin(), l_counts.end(),
+                                     size_t{0});
+
+    if(l_total == 0)
+        return std::chrono::nanoseconds(0);
+
+    // the number of calls which must be at or below the result
+    size_t l_target = std::max<size_t>(1, std::ceil(a_fraction * l_total));
+
+    size_t l_cumulative = 0;
+    for(size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        l_cumulative += l_counts[i];
+
+        if(l_cumulative >= l_target)
+            return std::chrono::nanoseconds(i == 0 ? 0 : int64_t{1} << i);
+    }
+
+    return std::chrono::nanoseconds(int64_t{1} << (BUCKET_COUNT - 1));
+}
+
+std::string profiler::repr() const
+{
+    // order the profiles by total time, slowest first
+    std::vector<std::pair<std::string, const primitive_profile*>> l_entries;
+    for(const auto& [l_repr, l_profile] : m_profiles)
+        l_entries.emplace_back(l_repr, l_profile.get());
+
+    auto l_total_ns = [](const primitive_profile* a_profile)
+    { return a_profile->m_conversion_ns.load() + a_profile->m_call_ns.load(); };
+
+    std::stable_sort(l_entries.begin(), l_entries.end(),
+                     [&l_total_ns](const auto& a_lhs, const auto& a_rhs)
+                     { return l_total_ns(a_lhs.second) >
+                              l_total_ns(a_rhs.second); });
+
+    std::stringstream l_stream;
+
+    for(const auto& [l_repr, l_profile] : l_entries)
+    {
+        l_stream << l_repr << ": calls=" << l_profile->m_calls.load()
+                 << " call=" << l_profile->m_call_ns.load() / 1e6 << "ms"
+                 << " conversion=" << l_profile->m_conversion_ns.load() / 1e6
+                 << "ms"
+                 << " p50=" << l_profile->percentile(0.5).count() << "ns"
+                 << " p99=" << l_profile->percentile(0.99).count() << "ns"
+                 << std::endl;
+    }
+
+    return l_stream.str();
+}
+
+primitive_profile& profiler::profile(const std::string& a_repr)
+{
+    std::shared_ptr<primitive_profile>& l_profile = m_profiles[a_repr];
+
+    if(l_profile == nullptr)
+        l_profile = std::make_shared<primitive_profile>();
+
+    return *l_profile;
+}
+
+profiled_primitives::~profiled_primitives()
+{
+    for(auto& [l_func, l_definition] : m_definitions)
+        std::get<func::primitive>(l_func->m_body.m_functor).m_defn =
+            std::move(l_definition);
+}
+
+profiled_primitives profile_primitives(program& a_program,
+                                       profiler& a_profiler)
+{
+    profiled_primitives l_profiled;
+
+    for(const auto& l_func : a_program.m_funcs)
+    {
+        auto* l_primitive =
+            std::get_if<func::primitive>(&l_func->m_body.m_functor);
+
+        // skip funcs defined by bodies, and primitives made by hand
+        if(l_primitive == nullptr || !l_primitive->m_make_profiled)
+            continue;
+
+        a_profiler.profile(l_func->m_repr);
+
+        l_profiled.m_definitions.emplace_back(l_func, l_primitive->m_defn);
+        l_primitive->m_defn = l_primitive->m_make_profiled(
+            a_profiler.m_profiles.at(l_func->m_repr));
+    }
+
+    return l_profiled;
+}
+
+void calibrate_costs(program& a_program, const profiler& a_profiler)
+{
+    // the mean time per call of each primitive called
+    std::map<std::string, double> l_mean_ns;
+    for(const auto& [l_repr, l_profile] : a_profiler.m_profiles)
+    {
+        size_t l_calls = l_profile->m_calls.load();
+
+        if(l_calls > 0)
+            l_mean_ns[l_repr] = double(l_profile->m_conversion_ns.load() +
+                                       l_profile->m_call_ns.load()) /
+                                l_calls;
+    }
+
+    if(l_mean_ns.empty())
+        return;
+
+    // REASON: clamped, so that a primitive too fast to time is not free
+    double l_cheapest_ns = std::max(
+        1.0, std::min_element(l_mean_ns.begin(), l_mean_ns.end(),
+                              [](const auto& a_lhs, const auto& a_rhs)
+                              { return a_lhs.second < a_rhs.second; })
+                 ->second);
+
+    for(const auto& l_func : a_program.m_funcs)
+    {
+        auto l_entry = l_mean_ns.find(l_func->m_repr);
+
+        if(l_entry == l_mean_ns.end() ||
+           !std::holds_alternative<func::primitive>(l_func->m_body.m_functor))
+            continue;
+
+        l_func->m_properties.m_cost =
+            std::max(1.0, l_entry->second / l_cheapest_ns);
+    }
+}
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+#include <optional>
+#include <thread>
+
+void test_primitive_profile_percentile()
+{
+    primitive_profile l_profile;
+
+    // no calls
+    assert(l_profile.percentile(0.5).count() == 0);
+
+    // 90 fast calls and 10 slow calls
+    for(size_t i = 0; i < 90; ++i)
+        l_profile.record(std::chrono::nanoseconds(1),
+                         std::chrono::nanoseconds(100));
+    for(size_t i = 0; i < 10; ++i)
+        l_profile.record(std::chrono::nanoseconds(1),
+                         std::chrono::nanoseconds(5000));
+
+    assert(l_profile.m_calls.load() == 100);
+    assert(l_profile.m_conversion_ns.load() == 100);
+    assert(l_profile.m_call_ns.load() == 90 * 100 + 10 * 5000);
+
+    // the bounds are the next power of two
+    assert(l_profile.percentile(0.5).count() == 128);
+    assert(l_profile.percentile(0.9).count() == 128);
+    assert(l_profile.percentile(0.99).count() == 8192);
+    assert(l_profile.percentile(1).count() == 8192);
+}
+
+void test_profile_primitives()
+{
+    program l_program;
+
+    auto l_succ = l_program.add_primitive(
+        "succ", std::function([](int a_x) { return a_x + 1; }));
+    auto l_slow = l_program.add_primitive(
+        "slow",
+        std::function(
+            [](const std::string& a_x)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                return a_x.size();
+            }));
+
+    // a binning function over succ, which is not itself a primitive
+    func::body l_body{
+        .m_functor = l_succ,
+        .m_children = {func::body{
+            .m_functor = l_succ,
+            .m_children = {func::body{.m_functor = func::param{0}}},
+        }},
+    };
+    l_program.m_funcs.push_back(std::make_shared<func>(
+        typeid(int), std::multimap<std::type_index, size_t>{{typeid(int), 0}},
+        l_body, "succ(succ(?0))"));
+
+    profiler l_profiler;
+    std::optional<profiled_primitives> l_profiled =
+        profile_primitives(l_program, l_profiler);
+
+    // only primitives are profiled
+    assert(l_profiler.m_profiles.size() == 2);
+
+    // results are unchanged
+    std::vector<std::any> l_int_args{std::any(5)};
+    assert(std::any_cast<int>(l_program.m_funcs.back()->m_body.eval(
+               l_int_args.data(), l_int_args.size())) == 7);
+
+    std::vector<std::any> l_string_args{std::any(std::string("abc"))};
+    assert(std::any_cast<size_t>(l_slow->m_body.eval(
+               l_string_args.data(), l_string_args.size())) == 3);
+
+    // the calls are counted by repr
+    assert(l_profiler.m_profiles.at("succ")->m_calls.load() == 2);
+    assert(l_profiler.m_profiles.at("slow")->m_calls.load() == 1);
+
+    // the latency is measured
+    assert(l_profiler.m_profiles.at("slow")->m_call_ns.load() >= 1000000);
+    assert(l_profiler.m_profiles.at("slow")->percentile(0.5) >=
+           std::chrono::milliseconds(1));
+
+    // the slowest primitive is reported first
+    std::string l_repr = l_profiler.repr();
+    assert(l_repr.find("slow: calls=1 ") == 0);
+    assert(l_repr.find("\nsucc: calls=2 ") != std::string::npos);
+
+    // once the guard is destroyed, the definitions are put back
+    l_profiled.reset();
+    assert(std::any_cast<int>(l_program.m_funcs.back()->m_body.eval(
+               l_int_args.data(), l_int_args.size())) == 7);
+    assert(l_profiler.m_profiles.at("succ")->m_calls.load() == 2);
+}
+
+void test_calibrate_costs()
+{
+    program l_program;
+
+    l_program.add_primitive("succ",
+                            std::function([](int a_x) { return a_x + 1; }));
+    l_program.add_primitive(
+        "slow", std::function([](int a_x) { return a_x - 1; }));
+    l_program.add_primitive("unused",
+                            std::function([](int a_x) { return a_x; }),
+                            {.m_cost = 3});
+
+    // slow takes ten times as long per call
+    profiler l_profiler;
+    for(size_t i = 0; i < 10; ++i)
+        l_profiler.profile("succ").record(std::chrono::nanoseconds(20),
+                                          std::chrono::nanoseconds(80));
+    for(size_t i = 0; i < 5; ++i)
+        l_profiler.profile("slow").record(std::chrono::nanoseconds(20),
+                                          std::chrono::nanoseconds(980));
+    l_profiler.profile("unused");
+
+    calibrate_costs(l_program, l_profiler);
+
+    auto l_it = l_program.m_funcs.begin();
+    assert((*l_it++)->m_properties.m_cost == 1);
+    assert((*l_it++)->m_properties.m_cost == 10);
+
+    // primitives never called keep their cost
+    assert((*l_it++)->m_properties.m_cost == 3);
+}
+
+void profile_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_primitive_profile_percentile);
+    TEST(test_profile_primitives);
+    TEST(test_calibrate_costs);
+}
+
+#endif
@@ -1,7 +1,9 @@
 #include "../include/program.hpp"
 
 #include <cmath>
+#include <numeric>
 #include <sstream>
+#include <span>
 
 #ifdef UNIT_TEST
 
@@ -316,12 +318,149 @@ void test_program_add_primitive()
     }
 }
 
+void test_program_add_primitive_properties()
+{
+    program l_program;
+
+    // no properties by default
+    auto l_and = l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; }));
+    assert(!l_and->m_properties.m_commutative);
+    assert(!l_and->m_properties.m_associative);
+
+    // declared properties are kept
+    auto l_exor = l_program.add_primitive(
+        "exor", std::function([](bool a_x, bool a_y) { return a_x != a_y; }),
+        {.m_commutative = true, .m_associative = true});
+    assert(l_exor->m_properties.m_commutative);
+    assert(l_exor->m_properties.m_associative);
+
+    auto l_sum_3 = l_program.add_primitive(
+        "sum_3",
+        std::function([](int a_x, int a_y, int a_z)
+                      { return a_x + a_y + a_z; }),
+        {.m_commutative = true});
+    assert(l_sum_3->m_properties.m_commutative);
+
+    // args of different types cannot be reordered
+    assert_throws(l_program.add_primitive(
+                      "at", std::function([](std::string a_x, size_t a_i)
+                                          { return a_x[a_i]; }),
+                      {.m_commutative = true}),
+                  std::runtime_error);
+
+    // a single arg cannot be reordered
+    assert_throws(l_program.add_primitive(
+                      "not", std::function([](bool a_x) { return !a_x; }),
+                      {.m_commutative = true}),
+                  std::runtime_error);
+
+    // args which are not results cannot be regrouped
+    assert_throws(l_program.add_primitive(
+                      "less", std::function([](int a_x, int a_y)
+                                            { return a_x < a_y; }),
+                      {.m_associative = true}),
+                  std::runtime_error);
+
+    assert_throws(l_program.add_primitive(
+                      "sum_3_assoc",
+                      std::function([](int a_x, int a_y, int a_z)
+                                    { return a_x + a_y + a_z; }),
+                      {.m_associative = true}),
+                  std::runtime_error);
+
+    // nothing was added by the failed calls
+    assert(l_program.m_funcs.size() == 3);
+}
+
+void test_program_add_primitive_container_params()
+{
+    program l_program;
+
+    // a const reference param reads the value in the any
+    const int* l_seen = nullptr;
+    auto l_first = l_program.add_primitive(
+        "first", std::function(
+                     [&l_seen](const std::vector<int>& a_v, int a_i)
+                     {
+                         l_seen = a_v.data();
+                         return a_v[a_i];
+                     }));
+
+    // and its param type is that of the value
+    assert(l_first->m_param_types.count(typeid(std::vector<int>)) == 1);
+
+    // the definition reads its args where they lie
+    const auto& l_defn =
+        std::get<func::primitive>(l_first->m_body.m_functor).m_defn;
+    std::vector<std::any> l_input{std::vector<int>{4, 5, 6}, 1};
+    assert(std::any_cast<int>(l_defn(l_input.data(), l_input.size())) == 5);
+    assert(l_seen ==
+           std::any_cast<std::vector<int>>(&l_input[0])->data());
+
+    // a span param views a list stored elsewhere, so copying it to
+    // evaluate the body copies no values
+    std::vector<int> l_list{1, 2, 3, 4};
+    auto l_sum = l_program.add_primitive(
+        "sum", std::function(
+                   [&l_seen](std::span<const int> a_v)
+                   {
+                       l_seen = a_v.data();
+                       return std::accumulate(a_v.begin(), a_v.end(), 0);
+                   }));
+
+    assert(l_sum->m_param_types.count(typeid(std::span<const int>)) == 1);
+
+    std::any l_span = std::span<const int>(l_list);
+    assert(std::any_cast<int>(l_sum->m_body.eval(&l_span, 1)) == 10);
+    assert(l_seen == l_list.data());
+}
+
 void program_test_main()
 {
     constexpr bool ENABLE_DEBUG_LOGS = true;
 
     TEST(test_make_general_function);
     TEST(test_program_add_primitive);
+    TEST(test_program_add_primitive_properties);
+    TEST(test_program_add_primitive_container_params);
+}
+
+#endif
+
+#ifdef BENCHMARK
+
+#include "bench_utils.hpp"
+
+void bench_make_general_function()
+{
+    std::vector<std::any> l_input(4, std::any(1));
+
+    // measure the call overhead of a general function of some arity
+    auto l_measure = [&l_input](size_t a_arity, auto a_function)
+    {
+        auto l_general_function =
+            make_general_function(std::function(a_function));
+
+        bench("make_general_function", {{"arity", a_arity}},
+              [&]()
+              {
+                  do_not_optimize(
+                      l_general_function(l_input.data(), a_arity));
+              });
+    };
+
+    l_measure(0, []() { return 1; });
+    l_measure(1, [](int a_x) { return a_x; });
+    l_measure(2, [](int a_x, int a_y) { return a_x + a_y; });
+    l_measure(3, [](int a_x, int a_y, int a_z) { return a_x + a_y + a_z; });
+    l_measure(4, [](int a_x, int a_y, int a_z, int a_w)
+              { return a_x + a_y + a_z + a_w; });
+}
+
+void program_bench_main()
+{
+    BENCH(bench_make_general_function);
 }
 
 #endif
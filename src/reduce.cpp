@@ -1,45 +1,45 @@
 #include "../include/reduce.hpp"
-#include "../include/model.hpp"
-#include "../include/program.hpp"
-#include "../include/scope.hpp"
-#include "../mcts/include/mcts.hpp"
-#include <iostream>
-#include <random>
-#include <sstream>
+#include "../include/minimize.hpp"
+#include <array>
+#include <bit>
+#include <cmath>
 
 ////////////////////////////////////////////////////
-//////////////// COMPARISON OPERATORS //////////////
+//////////////// FUNCTION GENERATION ///////////////
 ////////////////////////////////////////////////////
 
-bool operator<(const place_param_node& a_lhs, const place_param_node& a_rhs)
-{
-    return false;
-}
-bool operator<(const place_func_node& a_lhs, const place_func_node& a_rhs)
-{
-    return a_lhs.m_func < a_rhs.m_func;
-}
-bool operator<(const terminate&, const terminate&)
+// the choices made so far for a body, and what keeps the args of
+// commutative and associative funcs in canonical order
+struct canonical_context
 {
-    return false;
-}
-bool operator<(const make_function&, const make_function&)
+    // every choice so far, in pre-order
+    std::vector<choice> m_choices;
+
+    // for each open arg of a commutative func, the choices of its earlier
+    // sibling which it has matched so far: [next, end) of m_choices. once
+    // the arg differs from the sibling, the range is emptied.
+    std::vector<std::pair<size_t, size_t>> m_bounds;
+};
+
+// true if the choice places the func
+bool places_func(const choice& a_choice, const func* a_func)
 {
-    return false;
+    const auto* l_place_func_node = std::get_if<place_func_node>(&a_choice);
+    return l_place_func_node != nullptr && l_place_func_node->m_func == a_func;
 }
 
-////////////////////////////////////////////////////
-//////////////// FUNCTION GENERATION ///////////////
-////////////////////////////////////////////////////
-
-func::body
-build_function(program& a_program, scope& a_scope,
-               std::multimap<std::type_index, size_t>& a_param_types,
-               std::stringstream& a_repr_stream,
-               const std::type_index& a_return_type,
-               const bool& a_allow_adding_params,
-               monte_carlo::simulation<choice, std::mt19937>& a_simulation,
-               const size_t& a_recursion_limit)
+// build_function, given the canonical context. a_excluded_func may not
+// be placed at the root, and a_chain_func may be placed at the root
+// regardless of the innermost bound, which then applies to its first
+// arg instead.
+func::body build_canonical_function(
+    program& a_program, scope& a_scope,
+    std::multimap<std::type_index, size_t>& a_param_types,
+    std::stringstream& a_repr_stream, const std::type_index& a_return_type,
+    const bool& a_allow_adding_params,
+    rollout<choice, std::mt19937>& a_rollout,
+    const size_t& a_recursion_limit, canonical_context& a_context,
+    const func* a_excluded_func, const func* a_chain_func)
 {
     ////////////////////////////////////////////////////
     /////////////// GET THE SCOPE RANGES ///////////////
@@ -83,10 +83,65 @@ build_function(program& a_program, scope& a_scope,
     if(a_allow_adding_params)
         l_node_choices.push_back(place_param_node{a_param_types.size()});
 
+    ////////////////////////////////////////////////////
+    ///////////// KEEP ONLY CANONICAL CHOICES //////////
+    ////////////////////////////////////////////////////
+
+    // true if the bound is the one a_chain_func may skip
+    auto l_is_chained = [&a_context, a_chain_func](size_t a_bound,
+                                                   const choice& a_choice)
+    {
+        return a_bound + 1 == a_context.m_bounds.size() &&
+               places_func(a_choice, a_chain_func);
+    };
+
+    // REASON: an arg may not come before its earlier sibling in
+    // pre-order. since the sibling was built under the same type and
+    // recursion limit, the choice it made here is always still allowed.
+    std::erase_if(l_node_choices,
+                  [&a_context, &l_is_chained](const choice& a_choice)
+                  {
+                      for(size_t i = 0; i < a_context.m_bounds.size(); ++i)
+                      {
+                          const auto& [l_next, l_end] = a_context.m_bounds[i];
+
+                          if(l_next != l_end && !l_is_chained(i, a_choice) &&
+                             canonical_less(a_choice,
+                                            a_context.m_choices[l_next]))
+                              return true;
+                      }
+
+                      return false;
+                  });
+
+    // nest an associative func to the right, unless nothing else fits
+    auto l_is_excluded = [a_excluded_func](const choice& a_choice)
+    { return places_func(a_choice, a_excluded_func); };
+
+    if(!std::all_of(l_node_choices.begin(), l_node_choices.end(),
+                    l_is_excluded))
+        std::erase_if(l_node_choices, l_is_excluded);
+
     ////////////////////////////////////////////////////
     ////////////// CHOOSE A NODE TO PLACE //////////////
     ////////////////////////////////////////////////////
-    choice l_node_choice = a_simulation.choose(l_node_choices);
+    choice l_node_choice = a_rollout.choose(l_node_choices);
+
+    // advance past the choice in every bound it matches
+    for(size_t i = 0; i < a_context.m_bounds.size(); ++i)
+    {
+        auto& [l_next, l_end] = a_context.m_bounds[i];
+
+        if(l_next == l_end || l_is_chained(i, l_node_choice))
+            continue;
+
+        if(canonical_less(a_context.m_choices[l_next], l_node_choice))
+            l_next = l_end;
+        else
+            ++l_next;
+    }
+
+    a_context.m_choices.push_back(l_node_choice);
 
     // if the choice is a place_param_node
     if(const auto& l_place_param_node =
@@ -118,19 +173,46 @@ build_function(program& a_program, scope& a_scope,
     ////////////////////////////////////////////////////
     //////////////// CONSTRUCT CHILDREN ////////////////
     ////////////////////////////////////////////////////
-    size_t l_node_arity = l_node_func->m_param_types.size();
+    const func::properties& l_properties = l_node_func->m_properties;
 
     // pre-allocate the args vector
     std::vector<func::body> l_node_children(l_node_func->m_param_types.size());
 
+    // where the choices of the previous arg start
+    size_t l_previous_start = 0;
+
     // loop through with iterator, construct args in place
+    // REASON: the params of a commutative func share a type, so they are
+    // visited in order of index
     for(auto l_param_type_it = l_node_func->m_param_types.begin();
         l_param_type_it != l_node_func->m_param_types.end(); ++l_param_type_it)
     {
-        l_node_children[l_param_type_it->second] =
-            build_function(a_program, a_scope, a_param_types, a_repr_stream,
-                           l_param_type_it->first, a_allow_adding_params,
-                           a_simulation, a_recursion_limit - 1);
+        bool l_is_first = l_param_type_it == l_node_func->m_param_types.begin();
+        size_t l_start = a_context.m_choices.size();
+
+        // an arg of a commutative func may not come before the previous
+        if(l_properties.m_commutative && !l_is_first)
+            a_context.m_bounds.emplace_back(l_previous_start, l_start);
+
+        // REASON: for a func which is both, f(a, f(b, c)) is canonical
+        // when a <= b <= c, so the bound on f(b, c) applies to b
+        const func* l_excluded_func =
+            l_properties.m_associative && l_is_first ? l_node_func : nullptr;
+        const func* l_chain_func = l_properties.m_associative &&
+                                           l_properties.m_commutative &&
+                                           !l_is_first
+                                       ? l_node_func
+                                       : nullptr;
+
+        l_node_children[l_param_type_it->second] = build_canonical_function(
+            a_program, a_scope, a_param_types, a_repr_stream,
+            l_param_type_it->first, a_allow_adding_params, a_rollout,
+            a_recursion_limit - 1, a_context, l_excluded_func, l_chain_func);
+
+        if(l_properties.m_commutative && !l_is_first)
+            a_context.m_bounds.pop_back();
+
+        l_previous_start = l_start;
 
         // if this is not the last param, add a comma
         if(std::next(l_param_type_it) != l_node_func->m_param_types.end())
@@ -148,17 +230,87 @@ build_function(program& a_program, scope& a_scope,
     };
 }
 
-model build_model(
-    program& a_program, scope& a_scope,
-    std::multimap<std::type_index, size_t>& a_param_types,
-    const std::vector<std::pair<std::vector<std::any>, bool>>& a_data,
-    monte_carlo::simulation<choice, std::mt19937>& a_simulation,
-    const size_t& a_recursion_limit)
+func::body
+build_function(program& a_program, scope& a_scope,
+               std::multimap<std::type_index, size_t>& a_param_types,
+               std::stringstream& a_repr_stream,
+               const std::type_index& a_return_type,
+               const bool& a_allow_adding_params,
+               rollout<choice, std::mt19937>& a_rollout,
+               const size_t& a_recursion_limit)
+{
+    canonical_context l_context;
+
+    return build_canonical_function(
+        a_program, a_scope, a_param_types, a_repr_stream, a_return_type,
+        a_allow_adding_params, a_rollout, a_recursion_limit, l_context,
+        nullptr, nullptr);
+}
+
+// about a_size of the rows, with each label in proportion and at least
+// once, spread evenly over the rows
+std::vector<size_t> stratified_sample(const data_view& a_data,
+                                      const std::vector<size_t>& a_rows,
+                                      const size_t& a_size)
+{
+    std::vector<size_t> l_rows_of_label[2];
+    for(size_t l_row : a_rows)
+        l_rows_of_label[a_data.label(l_row)].push_back(l_row);
+
+    std::vector<size_t> l_sample;
+
+    for(const std::vector<size_t>& l_rows : l_rows_of_label)
+    {
+        if(l_rows.empty())
+            continue;
+
+        size_t l_count = std::clamp<size_t>(
+            a_size * l_rows.size() / a_rows.size(), 1, l_rows.size());
+
+        for(size_t i = 0; i < l_count; ++i)
+            l_sample.push_back(l_rows[i * l_rows.size() / l_count]);
+    }
+
+    return l_sample;
+}
+
+// the entropy of the labels of a bin, in bits, times its size. the
+// smaller the sum over the bins of a split, the more it tells of the
+// labels.
+double weighted_entropy(const size_t& a_negatives, const size_t& a_positives)
+{
+    double l_entropy = 0;
+
+    for(size_t l_count : {a_negatives, a_positives})
+        if(l_count > 0)
+            l_entropy -= l_count * std::log2(double(l_count) /
+                                             (a_negatives + a_positives));
+
+    return l_entropy;
+}
+
+// build a model of the given rows of the data, a_depth splits deep.
+// a_buffer holds the params of a row, for sources which do not store
+// rows.
+model build_model_on_rows(program& a_program, scope& a_scope,
+                          std::multimap<std::type_index, size_t>& a_param_types,
+                          const data_view& a_data,
+                          const std::vector<size_t>& a_rows,
+                          const std::vector<size_t>& a_weights,
+                          std::any* a_buffer,
+                          rollout<choice, std::mt19937>& a_rollout,
+                          const size_t& a_recursion_limit,
+                          const double& a_reward_bound, search_stats* a_stats,
+                          trace* a_trace, const binning_config& a_binning,
+                          const size_t& a_depth)
 {
+    trace_span l_span(a_trace, "build_model");
+    l_span.arg("rows", a_rows.size());
+
     ////////////////////////////////////////////////////
     //////////////// CHECK FOR TRIVIALITY //////////////
     ////////////////////////////////////////////////////
-    if(a_data.empty())
+    if(a_rows.empty())
         throw std::runtime_error("Error: no data points to build model from.");
 
     ////////////////////////////////////////////////////
@@ -166,19 +318,52 @@ model build_model(
     ////////////////////////////////////////////////////
 
     // get the first label
-    bool l_homogenous_value = a_data.begin()->second;
+    bool l_homogenous_value = a_data.label(a_rows.front());
 
     // loop through the data points, check for homogeneity
     bool l_data_is_homogenous =
-        std::all_of(a_data.begin(), a_data.end(),
-                    [l_homogenous_value](const auto& a_data_point)
-                    { return a_data_point.second == l_homogenous_value; });
+        std::all_of(a_rows.begin(), a_rows.end(),
+                    [&a_data, l_homogenous_value](size_t a_row)
+                    { return a_data.label(a_row) == l_homogenous_value; });
 
     // if the data is homogenous, return the appropriate
     // constant
     if(l_data_is_homogenous)
         return model{.m_homogenous_value = l_homogenous_value};
 
+    ////////////////////////////////////////////////////
+    ////////////// CHECK FOR A LEAF OF NOISE ///////////
+    ////////////////////////////////////////////////////
+
+    // REASON: on noisy data, splitting until every bin is pure makes
+    // enormous models, so a bin which is pure, small or deep enough is
+    // left as a leaf of its majority label, and its errors are counted
+    if(a_binning.m_leaf_purity < 1 || a_binning.m_min_split_size > 0 ||
+       a_binning.m_max_depth != std::numeric_limits<size_t>::max())
+    {
+        size_t l_label_counts[2] = {0, 0};
+
+        for(size_t l_row : a_rows)
+            l_label_counts[a_data.label(l_row)] +=
+                a_weights.empty() ? 1 : a_weights[l_row];
+
+        size_t l_count = l_label_counts[false] + l_label_counts[true];
+        bool l_majority = l_label_counts[true] > l_label_counts[false];
+
+        if(l_label_counts[l_majority] >= a_binning.m_leaf_purity * l_count ||
+           l_count < a_binning.m_min_split_size ||
+           a_depth >= a_binning.m_max_depth)
+        {
+            if(a_stats != nullptr)
+                ++a_stats->m_impure_leaves;
+
+            return model{
+                .m_homogenous_value = l_majority,
+                .m_error_count = l_label_counts[!l_majority],
+            };
+        }
+    }
+
     ////////////////////////////////////////////////////
     /////////////// CREATE BINNING FUNCTION ////////////
     ////////////////////////////////////////////////////
@@ -186,11 +371,13 @@ model build_model(
     // declare return type
     const std::type_index BINNING_RETURN_TYPE = std::type_index(typeid(bool));
 
+    // REASON: bins hold the indices of their rows, so that splitting
+    // never copies the data
     // construct the negative bin
-    std::vector<std::pair<std::vector<std::any>, bool>> l_negative_bin;
+    std::vector<size_t> l_negative_bin;
 
     // construct the positive bin
-    std::vector<std::pair<std::vector<std::any>, bool>> l_positive_bin;
+    std::vector<size_t> l_positive_bin;
 
     // declare the binning function body
     func::body l_binning_function_body;
@@ -199,48 +386,239 @@ model build_model(
     std::stringstream l_repr_stream;
 
     // create a copy of the original program
-    program l_original_program = a_program;
+    program l_original_program;
+    {
+        scoped_timer l_timer(a_stats ? &a_stats->m_program_copy_time
+                                     : nullptr);
+        l_original_program = a_program;
+    }
+
+    // the number of batches of binning functions built for this split
+    size_t l_attempts = 0;
+
+    // a hash of which rows went to the positive bin
+    uint64_t l_split_key = 0;
+
+    // the rows binning functions are first evaluated on, if sampling
+    size_t l_sample_size = a_binning.m_sample_size;
+    std::vector<size_t> l_sample;
+    size_t l_sampled_size = 0;
+
+    // whether a binning function splits the sample
+    auto l_splits_sample = [&](const func::body& a_body)
+    {
+        scoped_timer l_timer(a_stats ? &a_stats->m_bin_evaluation_time
+                                     : nullptr);
+        trace_span l_sample_span(a_trace, "evaluate_sample");
+
+        if(l_sampled_size != l_sample_size)
+        {
+            l_sample = stratified_sample(a_data, a_rows, l_sample_size);
+            l_sampled_size = l_sample_size;
+        }
+
+        l_sample_span.arg("rows", l_sample.size());
+
+        // the results seen, stopping once both are
+        bool l_seen[2] = {false, false};
+        size_t l_evaluated = 0;
+
+        for(size_t l_row : l_sample)
+        {
+            std::span<const std::any> l_x = a_data.params(l_row, a_buffer);
+            l_seen[std::any_cast<bool>(a_body.eval(l_x.data(), l_x.size()))] =
+                true;
+            ++l_evaluated;
+
+            if(l_seen[false] && l_seen[true])
+                break;
+        }
+
+        if(a_stats != nullptr)
+            a_stats->m_rows_evaluated += l_evaluated;
+
+        return l_seen[false] && l_seen[true];
+    };
+
+    // the binning functions of a batch, and their reprs
+    std::vector<func::body> l_candidates;
+    std::vector<std::string> l_candidate_reprs;
+
+    // the result of each candidate on each row, a row at a time
+    std::vector<uint8_t> l_results;
 
     // loop until neither output bin is empty
     // REASON: if one of the bins is empty, the binning
     // function is useless
     while(l_negative_bin.empty() || l_positive_bin.empty())
     {
+        ++l_attempts;
+
+        trace_span l_attempt_span(a_trace, "binning_attempt");
+        l_attempt_span.arg("attempt", l_attempts);
+
         // clear BOTH bins in case one contains items
         l_negative_bin.clear();
         l_positive_bin.clear();
 
-        // clear the repr stream
-        l_repr_stream.str("");
+        l_split_key = 0;
 
         // restore the original program
-        a_program = l_original_program;
+        {
+            scoped_timer l_timer(a_stats ? &a_stats->m_program_copy_time
+                                         : nullptr);
+            a_program = l_original_program;
+        }
+
+        l_candidates.clear();
+        l_candidate_reprs.clear();
+
+        for(size_t k = 0; k < a_binning.m_candidate_count; ++k)
+        {
+            // clear the repr stream
+            l_repr_stream.str("");
+
+            // construct the binning function body
+            // [create a binning function that will bin (evaluate
+            // on) each data point]
+            func::body l_candidate;
+            {
+                scoped_timer l_timer(
+                    a_stats ? &a_stats->m_build_function_time : nullptr);
+                l_candidate = build_function(
+                    a_program, a_scope, a_param_types, l_repr_stream,
+                    BINNING_RETURN_TYPE, false, a_rollout, a_recursion_limit);
+            }
+
+            // REASON: a function which leaves a bin of the sample empty
+            // most likely leaves one of the whole bin empty, so it is
+            // dropped without evaluating the rest. the sample doubles
+            // with each one dropped, so that a bin which only rare
+            // functions split is still split, and the bins are always
+            // those of the whole bin.
+            if(l_sample_size > 0 && l_sample_size < a_rows.size() &&
+               !l_splits_sample(l_candidate))
+            {
+                if(a_stats != nullptr)
+                    ++a_stats->m_sample_rejections;
+
+                l_sample_size = std::min(l_sample_size * 2, a_rows.size());
+                continue;
+            }
+
+            l_candidates.push_back(std::move(l_candidate));
+            l_candidate_reprs.push_back(l_repr_stream.str());
+        }
 
-        // construct the binning function body
-        // [create a binning function that will bin (evaluate
-        // on) each data point]
-        l_binning_function_body = build_function(
-            a_program, a_scope, a_param_types, l_repr_stream,
-            BINNING_RETURN_TYPE, false, a_simulation, a_recursion_limit);
+        l_attempt_span.arg("candidates", l_candidates.size());
+
+        if(l_candidates.empty())
+            continue;
 
         ////////////////////////////////////////////////////
-        ////////////// EVALUATE BINNING FUNCTION ///////////
+        ////////////// EVALUATE BINNING FUNCTIONS //////////
         ////////////////////////////////////////////////////
+        scoped_timer l_timer(a_stats ? &a_stats->m_bin_evaluation_time
+                                     : nullptr);
+        trace_span l_evaluate_span(a_trace, "evaluate_bins");
+        l_evaluate_span.arg("rows", a_rows.size());
+
+        const size_t l_candidate_count = l_candidates.size();
+
+        if(a_stats != nullptr)
+            a_stats->m_rows_evaluated += a_rows.size() * l_candidate_count;
+
+        // the rows of each candidate by result and label, as
+        // negative-false, negative-true, positive-false, positive-true
+        std::vector<std::array<size_t, 4>> l_counts(l_candidate_count);
+
+        l_results.resize(a_rows.size() * l_candidate_count);
+
+        // REASON: every candidate is evaluated on a row before moving to
+        // the next, so that the params of each row are read once
+        for(size_t i = 0; i < a_rows.size(); ++i)
+        {
+            std::span<const std::any> l_x = a_data.params(a_rows[i], a_buffer);
+
+            // a single candidate needs no labels to be kept
+            bool l_label = l_candidate_count > 1 && a_data.label(a_rows[i]);
+
+            // REASON: a collapsed row stands for its duplicates, so the
+            // purity is that of the data rather than of the unique rows
+            size_t l_weight = a_weights.empty() ? 1 : a_weights[a_rows[i]];
 
-        // evaluate the binning function on all of the
-        // data points
-        for(const auto& [l_x, l_y] : a_data)
+            for(size_t k = 0; k < l_candidate_count; ++k)
+            {
+                // evaluate the binning function (should return bool)
+                bool l_binning_result = std::any_cast<bool>(
+                    l_candidates[k].eval(l_x.data(), l_x.size()));
+
+                l_results[i * l_candidate_count + k] = l_binning_result;
+                l_counts[k][2 * l_binning_result + l_label] += l_weight;
+            }
+        }
+
+        // keep the candidate whose bins are purest, of those which
+        // leave neither bin empty
+        size_t l_best = l_candidate_count;
+        double l_best_entropy = std::numeric_limits<double>::infinity();
+
+        for(size_t k = 0; k < l_candidate_count; ++k)
+        {
+            const std::array<size_t, 4>& l_count = l_counts[k];
+
+            if(l_count[0] + l_count[1] == 0 || l_count[2] + l_count[3] == 0)
+                continue;
+
+            double l_entropy = weighted_entropy(l_count[0], l_count[1]) +
+                               weighted_entropy(l_count[2], l_count[3]);
+
+            if(l_entropy < l_best_entropy)
+            {
+                l_best = k;
+                l_best_entropy = l_entropy;
+            }
+        }
+
+        if(l_best == l_candidate_count)
+            continue;
+
+        l_binning_function_body = std::move(l_candidates[l_best]);
+
+        // the bits of the rows not yet folded into the split key
+        uint64_t l_row_bits = 0;
+
+        // bin the rows by the results of the kept candidate
+        for(size_t i = 0; i < a_rows.size(); ++i)
         {
-            // evaluate the binning function (should return bool)
-            bool l_binning_result = std::any_cast<bool>(
-                l_binning_function_body.eval(l_x.data(), l_x.size()));
+            bool l_binning_result = l_results[i * l_candidate_count + l_best];
+
+            l_row_bits |= uint64_t(l_binning_result) << (i % 64);
+
+            if(i % 64 == 63 || i + 1 == a_rows.size())
+            {
+                l_split_key = mix_key(l_split_key, l_row_bits);
+                l_row_bits = 0;
+            }
 
             // store in the appropriate bin
             if(l_binning_result)
-                l_positive_bin.emplace_back(l_x, l_y);
+                l_positive_bin.push_back(a_rows[i]);
             else
-                l_negative_bin.emplace_back(l_x, l_y);
+                l_negative_bin.push_back(a_rows[i]);
         }
+
+        l_repr_stream.str(l_candidate_reprs[l_best]);
+    }
+
+    if(a_stats != nullptr)
+    {
+        ++a_stats->m_binning_functions;
+        a_stats->m_binning_retries += l_attempts - 1;
+        ++a_stats->m_retry_counts[l_attempts - 1];
+        ++a_stats->m_rows_per_split[a_rows.size()];
+        ++a_stats->m_binning_function_sizes[l_binning_function_body
+                                                .node_count()];
     }
 
     // construct the function definition
@@ -251,19 +629,51 @@ model build_model(
     // add the binning function to the program
     a_program.m_funcs.push_back(l_binning_function);
 
+    // the program alone bounds the reward from above, so once it
+    // cannot beat the bound, the rest of the rollout is wasted
+    double l_program_reward;
+    {
+        scoped_timer l_timer(a_stats ? &a_stats->m_node_count_time
+                                     : nullptr);
+        l_program_reward = -static_cast<double>(std::accumulate(
+            a_program.m_funcs.begin(), a_program.m_funcs.end(), size_t{0},
+            [](size_t a_acc, const auto& a_func)
+            { return a_acc + a_func->m_body.node_count(); }));
+    }
+
+    if(l_program_reward <= a_reward_bound)
+        throw pruned_rollout{l_program_reward};
+
+    // REASON: the rest of the rollout depends only on the rows of the
+    // bins still to be built and on the size of the program, so binning
+    // functions which split the rows alike, at the same cost, lead to
+    // equivalent states. the splits so far, in order, determine the rows
+    // of every pending bin. the cost of each binning function is mixed
+    // in too, since with the rows it bins it determines the inference
+    // cost accrued so far, which two functions of one size can differ in.
+    bool l_transposed = a_rollout.transpose(mix_key(
+        mix_key(mix_key(a_rollout.m_state_key, l_split_key),
+                uint64_t(-l_program_reward)),
+        std::bit_cast<uint64_t>(l_binning_function->cost())));
+
+    if(l_transposed && a_stats != nullptr)
+        ++a_stats->m_transpositions;
+
     ////////////////////////////////////////////////////
     //////////////////////// RECUR /////////////////////
     ////////////////////////////////////////////////////
 
     // construct the negative child
-    model l_negative_child =
-        build_model(a_program, a_scope, a_param_types, l_negative_bin,
-                    a_simulation, a_recursion_limit);
+    model l_negative_child = build_model_on_rows(
+        a_program, a_scope, a_param_types, a_data, l_negative_bin, a_weights,
+        a_buffer, a_rollout, a_recursion_limit, a_reward_bound, a_stats,
+        a_trace, a_binning, a_depth + 1);
 
     // construct the positive child
-    model l_positive_child =
-        build_model(a_program, a_scope, a_param_types, l_positive_bin,
-                    a_simulation, a_recursion_limit);
+    model l_positive_child = build_model_on_rows(
+        a_program, a_scope, a_param_types, a_data, l_positive_bin, a_weights,
+        a_buffer, a_rollout, a_recursion_limit, a_reward_bound, a_stats,
+        a_trace, a_binning, a_depth + 1);
 
     // construct the final node
     return model{
@@ -273,83 +683,142 @@ model build_model(
     };
 }
 
-template <typename... Params>
-model learn_model(
+model build_model(
     program& a_program, scope& a_scope,
-    const std::vector<std::pair<std::vector<std::any>, bool>>& a_data,
-    const size_t& a_iterations, const size_t& a_recursion_limit,
-    const double& a_exploration_constant)
+    std::multimap<std::type_index, size_t>& a_param_types,
+    const data_view& a_data, rollout<choice, std::mt19937>& a_rollout,
+    const size_t& a_recursion_limit, const double& a_reward_bound,
+    search_stats* a_stats, trace* a_trace, const binning_config& a_binning)
 {
-    std::mt19937 l_rnd_gen(27);
-    monte_carlo::tree_node<choice> l_root;
+    std::vector<size_t> l_rows(a_data.size());
+    std::iota(l_rows.begin(), l_rows.end(), 0);
 
-    // get the parameter types
-    std::vector<std::type_index> l_param_types_list = {typeid(Params)...};
+    return build_model(a_program, a_scope, a_param_types, a_data, l_rows, {},
+                       a_rollout, a_recursion_limit, a_reward_bound, a_stats,
+                       a_trace, a_binning);
+}
 
-    // convert the parameter types to a multimap
-    std::multimap<std::type_index, size_t> l_param_types;
-    for(size_t i = 0; i < l_param_types_list.size(); ++i)
-        l_param_types.emplace(l_param_types_list[i], i);
+model build_model(
+    program& a_program, scope& a_scope,
+    std::multimap<std::type_index, size_t>& a_param_types,
+    const data_view& a_data, const std::vector<size_t>& a_rows,
+    const std::vector<size_t>& a_weights,
+    rollout<choice, std::mt19937>& a_rollout, const size_t& a_recursion_limit,
+    const double& a_reward_bound, search_stats* a_stats, trace* a_trace,
+    const binning_config& a_binning)
+{
+    std::vector<std::any> l_buffer(a_data.param_count());
 
-    // initialize the best reward to the lowest possible
-    // value
-    double l_best_reward = -std::numeric_limits<double>::infinity();
-    model l_best_model;
+    return build_model_on_rows(a_program, a_scope, a_param_types, a_data,
+                               a_rows, a_weights, l_buffer.data(), a_rollout,
+                               a_recursion_limit, a_reward_bound, a_stats,
+                               a_trace, a_binning, 0);
+}
 
-    // save the original program and scope
-    program l_original_program = a_program;
-    scope l_original_scope = a_scope;
+double model_reward(const program& a_program, const model& a_model)
+{
+    // compute the number of nodes in the whole program
+    size_t l_program_node_count =
+        std::accumulate(a_program.m_funcs.begin(), a_program.m_funcs.end(),
+                        size_t{0}, [](size_t a_acc, const auto& a_func)
+                        { return a_acc + a_func->m_body.node_count(); });
+
+    // compute the number of nodes in the model
+    size_t l_model_node_count = a_model.node_count();
+
+    // compute the reward (negative number of nodes)
+    return -static_cast<double>(l_program_node_count + l_model_node_count);
+}
 
-    for(int i = 0; i < a_iterations; ++i)
+double inference_cost(const model& a_model, const data_view& a_data)
+{
+    if(a_data.size() == 0)
+        return 0;
+
+    double l_total_cost = 0;
+
+    std::vector<std::any> l_buffer(a_data.param_count());
+
+    for(size_t i = 0; i < a_data.size(); ++i)
     {
-        // construct the simulation
-        monte_carlo::simulation<choice, std::mt19937> l_sim(
-            l_root, a_exploration_constant, l_rnd_gen);
+        std::span<const std::any> l_x = a_data.params(i, l_buffer.data());
+        l_total_cost += a_model.cost(l_x.data(), l_x.size());
+    }
+
+    return l_total_cost / a_data.size();
+}
 
-        // restore the original program and scope
-        program l_program = l_original_program;
-        scope l_scope = l_original_scope;
+double model_reward(const program& a_program, const model& a_model,
+                    const data_view& a_data, const reward_mode& a_mode,
+                    const double& a_error_penalty)
+{
+    double l_penalty = a_error_penalty * a_model.error_count();
+
+    // REASON: the inference cost is a mean over the data points, so the
+    // penalty is too
+    if(a_mode == reward_mode::inference_cost)
+        return -inference_cost(a_model, a_data) -
+               (a_data.size() > 0 ? l_penalty / a_data.size() : 0);
+
+    return model_reward(a_program, a_model) - l_penalty;
+}
 
-        // construct the model
-        model l_model = build_model(l_program, l_scope, l_param_types, a_data,
-                                    l_sim, a_recursion_limit);
+void calibrate_costs(
+    program& a_program, scope& a_scope,
+    std::multimap<std::type_index, size_t> a_param_types,
+    const data_view& a_data, const size_t& a_function_count,
+    const size_t& a_recursion_limit, const uint32_t& a_seed)
+{
+    profiler l_profiler;
 
-        // compute the number of nodes in the whole program
-        size_t l_program_node_count =
-            std::accumulate(l_program.m_funcs.begin(), l_program.m_funcs.end(),
-                            size_t{0}, [](size_t a_acc, const auto& a_func)
-                            { return a_acc + a_func->m_body.node_count(); });
+    {
+        // REASON: profiling replaces the definitions of the primitives,
+        // which are shared with copies of the program, until this scope
+        // ends
+        profiled_primitives l_profiled =
+            profile_primitives(a_program, l_profiler);
 
-        // compute the number of nodes in the model
-        size_t l_model_node_count = l_model.node_count();
+        // evaluate random binning functions, spread out by the search
+        // tree
+        search_tree<choice> l_tree;
+        std::mt19937 l_rnd_gen(a_seed);
 
-        // compute the reward (negative number of nodes)
-        double l_reward =
-            -static_cast<double>(l_program_node_count + l_model_node_count);
+        std::vector<std::any> l_buffer(a_data.param_count());
 
-        // save best model
-        if(l_reward > l_best_reward)
+        for(size_t i = 0; i < a_function_count; ++i)
         {
-            l_best_reward = l_reward;
-            a_program = l_program;
-            a_scope = l_scope;
-            l_best_model = l_model;
+            rollout<choice, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+            std::stringstream l_repr_stream;
 
-            std::cout << l_program_node_count << " " << l_reward << std::endl;
+            func::body l_body = build_function(
+                a_program, a_scope, a_param_types, l_repr_stream,
+                typeid(bool), false, l_rollout, a_recursion_limit);
 
-            std::cout << "program: " << std::endl;
-            for(const auto& l_func : l_program.m_funcs)
-                std::cout << "    " << l_func->m_repr << std::endl;
+            for(size_t j = 0; j < a_data.size(); ++j)
+            {
+                std::span<const std::any> l_x =
+                    a_data.params(j, l_buffer.data());
+                l_body.eval(l_x.data(), l_x.size());
+            }
 
-            std::cout << "model: " << l_model.repr() << std::endl;
-            std::cout << std::endl;
+            l_rollout.terminate(0);
         }
-
-        // terminate the simulation
-        l_sim.terminate(l_reward);
     }
 
-    return l_best_model;
+    calibrate_costs(a_program, l_profiler);
+}
+
+void print_improvement(const double& a_reward, const program& a_program,
+                       const model& a_model)
+{
+    std::cout << a_reward << std::endl;
+
+    std::cout << "program: " << std::endl;
+    for(const auto& l_func : a_program.m_funcs)
+        std::cout << "    " << l_func->m_repr << std::endl;
+
+    std::cout << "model: " << a_model.repr() << std::endl;
+    std::cout << std::endl;
 }
 
 ////////////////////////////////////////////////////
@@ -358,8 +827,12 @@ model learn_model(
 #ifdef UNIT_TEST
 
 #include "test_utils.hpp"
+#include <cstdio>
+#include <filesystem>
 #include <random>
+#include <set>
 #include <sstream>
+#include <thread>
 
 // void test_zero_construct_and_equality_check()
 // {
@@ -1104,58 +1577,1019 @@ void test_learn_model()
                                                  ITERATIONS, 10, 1000);
     }
 
-    // // learn v[4] == param
-    // {
-    //     constexpr size_t ITERATIONS = 10000;
-
-    //     // 2 < string length < 5 data
-    //     std::vector<std::pair<std::tuple<std::vector<int>, int>, bool>>
-    //         l_og_data{
-    //             {{{1, 1, 12, 13, 1}, 1}, true},
-    //             {{{2, 5, 1, 9, 4}, 5}, false},
-    //             {{{4, 2, 2, 5, 4}, 2}, false},
-    //             {{{6, 8, 20, 2, 7, 8, 9}, 7}, true},
-    //             {{{7, 1, 7, 31, 7, 8, 9}, 3}, false},
-    //         };
-
-    //     // convert the data to a vector of pairs of vectors of any and bool
-    //     std::vector<std::pair<std::vector<std::any>, bool>> l_data;
-    //     for(const auto& l_example : l_og_data)
-    //         l_data.emplace_back(
-    //             std::vector<std::any>{std::get<0>(l_example.first),
-    //                                   std::get<1>(l_example.first)},
-    //             l_example.second);
-
-    //     // initialize the program and scope
-    //     program l_program;
-    //     scope l_scope;
-
-    //     // add primitive for 0
-    //     l_scope.add_function(
-    //         l_program.add_primitive("0", std::function([]() { return 0; })));
-
-    //     // add primitive for succ(n)
-    //     l_scope.add_function(l_program.add_primitive(
-    //         "succ", std::function([](int a_n) { return a_n + 1; })));
-
-    //     // add primitive for v[i]
-    //     l_scope.add_function(l_program.add_primitive(
-    //         "index", std::function(
-    //                      [](std::vector<int> a_v, int a_i)
-    //                      {
-    //                          // compute the index by modulus
-    //                          int l_index = a_i % a_v.size();
-    //                          return a_v[l_index];
-    //                      })));
-
-    //     // add primitive for ==
-    //     l_scope.add_function(l_program.add_primitive(
-    //         "<", std::function([](int a_x, int a_y) { return a_x < a_y; })));
-
-    //     // learn a model
-    //     model l_model = learn_model<std::vector<int>, int>(
-    //         l_program, l_scope, l_data, ITERATIONS, 10, 1000);
-    // }
+    // learn x < v[2]
+    {
+        constexpr size_t ITERATIONS = 2000;
+
+        std::vector<std::vector<int>> l_lists{
+            {1, 1, 12, 13, 1}, {2, 5, 1, 9, 4},     {4, 2, 2, 5, 4},
+            {6, 8, 20, 2, 7},  {7, 1, 7, 31, 7, 8}, {3, 3, 3},
+        };
+        std::vector<int> l_xs{1, 5, 2, 7, 3, 4};
+
+        // the lists are stored back to back, and passed as spans
+        typed_dataset<std::span<const int>, int> l_data;
+        for(size_t i = 0; i < l_lists.size(); ++i)
+        {
+            std::get<0>(l_data.m_columns).push_back(l_lists[i]);
+            std::get<1>(l_data.m_columns).push_back(l_xs[i]);
+            l_data.m_labels.push_back(l_xs[i] < l_lists[i][2]);
+        }
+
+        program l_program;
+        scope l_scope;
+
+        l_scope.add_function(
+            l_program.add_primitive("2", std::function([]() { return 2; })));
+
+        // v[i], by modulus
+        l_scope.add_function(l_program.add_primitive(
+            "index", std::function([](std::span<const int> a_v, int a_i)
+                                   { return a_v[a_i % a_v.size()]; })));
+
+        l_scope.add_function(l_program.add_primitive(
+            "<", std::function([](int a_x, int a_y) { return a_x < a_y; })));
+
+        model l_model = learn_model(
+            l_program, l_scope, l_data,
+            search_config{.m_iterations = ITERATIONS,
+                          .m_recursion_limit = 3,
+                          .m_exploration_constant = 10});
+
+        assert(l_model.repr() == "[<(?1,index(?0,2()))] ? {1} : {0}");
+    }
+}
+
+void test_learn_model_baseline()
+{
+    // learn a&&(b exor c exor d), starting from a minimized baseline
+    constexpr size_t ITERATIONS = 100;
+
+    // 13 of 16 rows, the rest are don't-cares
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{false, false, false, false}, false},
+        {{false, false, false, true}, false},
+        {{false, false, true, false}, false},
+        {{false, true, false, false}, false},
+        {{false, true, false, true}, false},
+        {{false, true, true, false}, false},
+        {{false, true, true, true}, false},
+        {{true, false, false, false}, false},
+        {{true, false, false, true}, true},
+        {{true, false, true, true}, false},
+        {{true, true, false, false}, true},
+        {{true, true, false, true}, false},
+        {{true, true, true, true}, true},
+    };
+
+    // initialize the program and scope
+    program l_program;
+    scope l_scope;
+
+    // add the primitives the minimizer emits
+    auto l_and = l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; }));
+    auto l_or = l_program.add_primitive(
+        "or", std::function([](bool a_x, bool a_y) { return a_x || a_y; }));
+    auto l_not = l_program.add_primitive(
+        "not", std::function([](bool a_x) { return !a_x; }));
+    l_scope.add_function(l_and);
+    l_scope.add_function(l_or);
+    l_scope.add_function(l_not);
+
+    // minimize the data into a baseline binning function
+    auto l_baseline =
+        make_sop_function(minimize_sop(l_data), 4, l_and, l_or, l_not);
+
+    // the reward of the baseline model
+    program l_baseline_program = l_program;
+    l_baseline_program.m_funcs.push_back(l_baseline);
+    double l_baseline_reward = model_reward(
+        l_baseline_program,
+        model{
+            .m_func = l_baseline.get(),
+            .m_negative_child =
+                std::make_shared<model>(model{.m_homogenous_value = false}),
+            .m_positive_child =
+                std::make_shared<model>(model{.m_homogenous_value = true}),
+        });
+
+    // learn a model
+    model l_model = learn_model<bool, bool, bool, bool>(
+        l_program, l_scope, l_data, ITERATIONS, 10, 100, l_baseline);
+
+    // the model is never worse than the baseline
+    assert(model_reward(l_program, l_model) >= l_baseline_reward);
+
+    // the model fits the data
+    for(const auto& [l_x, l_y] : l_data)
+        assert(l_model.eval(l_x.data(), l_x.size()) == l_y);
+}
+
+void test_learn_model_stats()
+{
+    // learn a exor b, with and without collecting stats
+    constexpr size_t ITERATIONS = 100;
+    constexpr size_t REPORT_INTERVAL = 30;
+
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{false, false}, false},
+        {{false, true}, true},
+        {{true, false}, true},
+        {{true, true}, false},
+    };
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "not", std::function([](bool a_x) { return !a_x; })));
+
+    const search_config CONFIG{
+        .m_iterations = ITERATIONS,
+        .m_recursion_limit = 3,
+        .m_exploration_constant = 100,
+    };
+
+    // search without stats
+    program l_plain_program = l_program;
+    scope l_plain_scope = l_scope;
+    model l_plain_model = learn_model<bool, bool>(
+        l_plain_program, l_plain_scope, l_data, CONFIG);
+
+    // search with stats, reporting periodically
+    search_stats l_stats;
+    std::vector<size_t> l_reported_iterations;
+    l_stats.m_report_interval = REPORT_INTERVAL;
+    l_stats.m_report = [&l_reported_iterations](const search_stats& a_stats)
+    { l_reported_iterations.push_back(a_stats.m_iterations); };
+
+    program l_stats_program = l_program;
+    scope l_stats_scope = l_scope;
+    model l_stats_model = learn_model<bool, bool>(
+        l_stats_program, l_stats_scope, l_data, CONFIG, nullptr, nullptr,
+        &l_stats);
+
+    // collecting stats does not change the search
+    assert(l_stats_model.repr() == l_plain_model.repr());
+
+    // every iteration is counted, and reported on the interval
+    assert(l_stats.m_iterations == ITERATIONS);
+    assert(l_reported_iterations == std::vector<size_t>({30, 60, 90}));
+    assert(l_stats.m_improvements >= 1);
+
+    // without a bound, every rollout completes a model
+    assert(l_stats.m_pruned_rollouts == 0);
+    size_t l_model_count = 0;
+    for(const auto& [l_depth, l_count] : l_stats.m_model_depths)
+    {
+        assert(l_depth >= 1);
+        l_model_count += l_count;
+    }
+    assert(l_model_count == ITERATIONS);
+
+    // the distributions agree with the counters
+    size_t l_split_count = 0;
+    size_t l_retry_count = 0;
+    for(const auto& [l_retries, l_count] : l_stats.m_retry_counts)
+    {
+        l_split_count += l_count;
+        l_retry_count += l_retries * l_count;
+    }
+    assert(l_split_count == l_stats.m_binning_functions);
+    assert(l_retry_count == l_stats.m_binning_retries);
+
+    size_t l_rows_binned = 0;
+    for(const auto& [l_rows, l_count] : l_stats.m_rows_per_split)
+        l_rows_binned += l_rows * l_count;
+    assert(l_stats.m_rows_evaluated >= l_rows_binned);
+
+    // the phases happen within the rollouts
+    assert(l_stats.m_rollout_time > std::chrono::steady_clock::duration{});
+    assert(l_stats.m_build_function_time + l_stats.m_bin_evaluation_time <=
+           l_stats.m_rollout_time);
+
+    // an interval of 0 never reports
+    search_stats l_silent_stats;
+    l_silent_stats.m_report_interval = 0;
+    l_silent_stats.m_report = [](const search_stats&) { assert(false); };
+
+    program l_silent_program = l_program;
+    scope l_silent_scope = l_scope;
+    learn_model<bool, bool>(l_silent_program, l_silent_scope, l_data, CONFIG,
+                            nullptr, nullptr, &l_silent_stats);
+    assert(l_silent_stats.m_iterations == ITERATIONS);
+}
+
+void test_learn_model_inference_cost()
+{
+    // learn x > 5, which two primitives compute at different costs
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data;
+    for(int i = 0; i < 10; ++i)
+        l_data.push_back({{i}, i > 5});
+
+    program l_program;
+    scope l_scope;
+
+    auto l_slow = l_program.add_primitive(
+        "slow_above_5", std::function([](int a_x) { return a_x > 5; }),
+        {.m_cost = 100});
+    auto l_fast = l_program.add_primitive(
+        "fast_above_5", std::function([](int a_x) { return a_x > 5; }));
+    l_scope.add_function(l_slow);
+    l_scope.add_function(l_fast);
+
+    double l_best_reward = -std::numeric_limits<double>::infinity();
+
+    const search_config CONFIG{
+        .m_iterations = 100,
+        .m_recursion_limit = 2,
+        .m_exploration_constant = 10,
+        .m_reward_mode = reward_mode::inference_cost,
+        .m_on_improvement = [&l_best_reward](const double& a_reward,
+                                             const program&, const model&)
+        { l_best_reward = a_reward; },
+    };
+
+    model l_model = learn_model<int>(l_program, l_scope, l_data, CONFIG);
+
+    // each row pays for the root, the binning function and its param,
+    // and a leaf
+
+    assert(l_model.repr() == "[fast_above_5(?0)] ? {1} : {0}");
+    assert(l_best_reward == -4);
+    assert(l_best_reward == -inference_cost(l_model, l_data));
+
+    // the two primitives split alike, but at different costs, so their
+    // states are not shared, even once both are explored
+    l_slow->m_properties.m_cost = 2;
+
+    program l_explored_program = l_program;
+    scope l_explored_scope = l_scope;
+    search_stats l_stats;
+
+    l_model = learn_model<int>(l_explored_program, l_explored_scope, l_data,
+                               CONFIG, nullptr, nullptr, &l_stats);
+
+    assert(l_model.repr() == "[fast_above_5(?0)] ? {1} : {0}");
+    assert(l_stats.m_transpositions == 0);
+
+    l_slow->m_properties.m_cost = 100;
+
+    // the cost of each path is weighted by the rows taking it. here an
+    // expensive check is only made on the 4 rows above 5.
+    model l_nested{
+        .m_func = l_fast,
+        .m_negative_child =
+            std::make_shared<model>(model{.m_homogenous_value = false}),
+        .m_positive_child = std::make_shared<model>(model{
+            .m_func = l_slow,
+            .m_negative_child =
+                std::make_shared<model>(model{.m_homogenous_value = false}),
+            .m_positive_child =
+                std::make_shared<model>(model{.m_homogenous_value = true}),
+        }),
+    };
+    assert(inference_cost(l_nested, l_data) ==
+           (6 * (1 + 1 + 1) + 4 * (1 + 1 + 1 + 100 + 1)) / 10.0);
+}
+
+void test_calibrate_costs_by_search()
+{
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data;
+    for(int i = 0; i < 8; ++i)
+        l_data.push_back({{i}, i % 2 == 0});
+
+    program l_program;
+    scope l_scope;
+
+    auto l_even = l_program.add_primitive(
+        "even", std::function([](int a_x) { return a_x % 2 == 0; }));
+    auto l_slow_odd = l_program.add_primitive(
+        "slow_odd", std::function(
+                        [](int a_x)
+                        {
+                            std::this_thread::sleep_for(
+                                std::chrono::microseconds(200));
+                            return a_x % 2 != 0;
+                        }));
+    l_scope.add_function(l_even);
+    l_scope.add_function(l_slow_odd);
+
+    calibrate_costs(l_program, l_scope, {{typeid(int), 0}}, l_data, 20, 1);
+
+    assert(l_even->m_properties.m_cost == 1);
+    assert(l_slow_odd->m_properties.m_cost > 10);
+
+    // the definitions are no longer profiled
+    std::vector<std::any> l_args{std::any(3)};
+    assert(std::any_cast<bool>(l_even->m_body.eval(l_args.data(), 1)) ==
+           false);
+}
+
+void test_build_function_canonical()
+{
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; }),
+        {.m_commutative = true}));
+    l_scope.add_function(l_program.add_primitive(
+        "exor", std::function([](bool a_x, bool a_y) { return a_x != a_y; }),
+        {.m_commutative = true, .m_associative = true}));
+    l_scope.add_function(l_program.add_primitive(
+        "implies",
+        std::function([](bool a_x, bool a_y) { return !a_x || a_y; })));
+
+    std::multimap<std::type_index, size_t> l_param_types{
+        {typeid(bool), 0}, {typeid(bool), 1}, {typeid(bool), 2}};
+
+    // the reprs of many bodies
+    auto l_generate = [&](size_t a_recursion_limit)
+    {
+        std::set<std::string> l_reprs;
+
+        search_tree<choice> l_tree;
+        std::mt19937 l_rnd_gen(27);
+
+        for(size_t i = 0; i < 20000; ++i)
+        {
+            rollout<choice, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+            std::stringstream l_repr_stream;
+
+            build_function(l_program, l_scope, l_param_types, l_repr_stream,
+                           typeid(bool), false, l_rollout, a_recursion_limit);
+
+            l_reprs.insert(l_repr_stream.str());
+            l_rollout.terminate(0);
+        }
+
+        return l_reprs;
+    };
+
+    // a single node has its args in order, unless it is not commutative
+    std::set<std::string> l_shallow = l_generate(1);
+    assert(l_shallow.size() == 3 + 6 + 6 + 9);
+    assert(l_shallow.contains("and(?0,?1)"));
+    assert(!l_shallow.contains("and(?1,?0)"));
+    assert(l_shallow.contains("and(?1,?1)"));
+    assert(l_shallow.contains("exor(?0,?2)"));
+    assert(!l_shallow.contains("exor(?2,?0)"));
+    assert(l_shallow.contains("implies(?1,?0)"));
+
+    // nested args are compared choice by choice, funcs before params,
+    // and chains of exor are nested to the right with their operands in
+    // order
+    std::set<std::string> l_deep = l_generate(2);
+    assert(l_deep.contains("and(and(?0,?1),?0)"));
+    assert(!l_deep.contains("and(?0,and(?0,?1))"));
+    assert(l_deep.contains("and(and(?0,?1),and(?0,?2))"));
+    assert(!l_deep.contains("and(and(?0,?2),and(?0,?1))"));
+    assert(l_deep.contains("exor(?0,exor(?1,?2))"));
+    assert(l_deep.contains("exor(?1,exor(?1,?2))"));
+    assert(!l_deep.contains("exor(?1,exor(?0,?2))"));
+    assert(!l_deep.contains("exor(?0,exor(?2,?1))"));
+    assert(l_deep.contains("exor(and(?0,?1),exor(?0,?1))"));
+
+    for(const std::string& l_repr : l_deep)
+        assert(l_repr.find("exor(exor(") == std::string::npos);
+}
+
+void test_learn_model_transpositions()
+{
+    // learn a exor b, where many binning functions split alike
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{false, false}, false},
+        {{false, true}, true},
+        {{true, false}, true},
+        {{true, true}, false},
+    };
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "or", std::function([](bool a_x, bool a_y) { return a_x || a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "not", std::function([](bool a_x) { return !a_x; })));
+
+    for(bool l_use_transpositions : {true, false})
+    {
+        const search_config CONFIG{
+            .m_iterations = 500,
+            .m_recursion_limit = 3,
+            .m_exploration_constant = 10,
+            .m_use_transpositions = l_use_transpositions,
+        };
+
+        program l_learned_program = l_program;
+        scope l_learned_scope = l_scope;
+        search_stats l_stats;
+
+        model l_model = learn_model<bool, bool>(
+            l_learned_program, l_learned_scope, l_data, CONFIG, nullptr,
+            nullptr, &l_stats);
+
+        // equivalent states are only shared when enabled
+        assert((l_stats.m_transpositions > 0) == l_use_transpositions);
+
+        // either way, the model is correct
+        for(const auto& [l_x, l_y] : l_data)
+            assert(l_model.eval(l_x.data(), l_x.size()) == l_y);
+    }
+}
+
+void test_learn_model_trace()
+{
+    // learn a exor b, recording a trace
+    constexpr size_t ITERATIONS = 20;
+
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{false, false}, false},
+        {{false, true}, true},
+        {{true, false}, true},
+        {{true, true}, false},
+    };
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "not", std::function([](bool a_x) { return !a_x; })));
+
+    trace l_trace;
+    search_stats l_stats;
+
+    learn_model<bool, bool>(l_program, l_scope, l_data,
+                            search_config{
+                                .m_iterations = ITERATIONS,
+                                .m_recursion_limit = 3,
+                                .m_exploration_constant = 100,
+                            },
+                            nullptr, nullptr, &l_stats, &l_trace);
+
+    std::map<std::string, size_t> l_span_counts;
+    for(const trace::event& l_event : l_trace.m_events)
+        ++l_span_counts[l_event.m_name];
+
+    // one span per iteration, and per attempt at each split
+    assert(l_span_counts["iteration"] == ITERATIONS);
+    assert(l_span_counts["binning_attempt"] ==
+           l_stats.m_binning_functions + l_stats.m_binning_retries);
+    assert(l_span_counts["evaluate_bins"] == l_span_counts["binning_attempt"]);
+
+    // every build_model call is within an iteration, and at least the
+    // root of each model is built
+    assert(l_span_counts["build_model"] >= ITERATIONS);
+
+    // the iterations carry their rewards
+    for(const trace::event& l_event : l_trace.m_events)
+        if(std::string(l_event.m_name) == "iteration")
+            assert(l_event.m_args.at("reward") < 0);
+}
+
+void test_learn_model_anytime()
+{
+    // learn a exor b
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{false, false}, false},
+        {{false, true}, true},
+        {{true, false}, true},
+        {{true, true}, false},
+    };
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "not", std::function([](bool a_x) { return !a_x; })));
+
+    // check that a model fits the data
+    auto l_fits = [&l_data](const model& a_model)
+    {
+        return std::all_of(l_data.begin(), l_data.end(),
+                           [&a_model](const auto& a_data_point)
+                           {
+                               return a_model.eval(
+                                          a_data_point.first.data(),
+                                          a_data_point.first.size()) ==
+                                      a_data_point.second;
+                           });
+    };
+
+    // improvements are reported through the callback
+    {
+        program l_search_program = l_program;
+        scope l_search_scope = l_scope;
+
+        std::vector<double> l_rewards;
+
+        model l_model = learn_model<bool, bool>(
+            l_search_program, l_search_scope, l_data,
+            search_config{
+                .m_iterations = 100,
+                .m_recursion_limit = 3,
+                .m_exploration_constant = 100,
+                .m_on_improvement =
+                    [&l_rewards](const double& a_reward, const program&,
+                                 const model&)
+                { l_rewards.push_back(a_reward); },
+            });
+
+        assert(!l_rewards.empty());
+        assert(std::is_sorted(l_rewards.begin(), l_rewards.end()));
+        assert(std::adjacent_find(l_rewards.begin(), l_rewards.end()) ==
+               l_rewards.end());
+        assert(l_rewards.back() == model_reward(l_search_program, l_model));
+    }
+
+    // the deadline stops an unbounded search
+    {
+        program l_search_program = l_program;
+        scope l_search_scope = l_scope;
+
+        auto l_start = std::chrono::steady_clock::now();
+
+        model l_model = learn_model<bool, bool>(
+            l_search_program, l_search_scope, l_data,
+            search_config{
+                .m_recursion_limit = 3,
+                .m_exploration_constant = 100,
+                .m_deadline = l_start + std::chrono::milliseconds(200),
+            });
+
+        assert(std::chrono::steady_clock::now() - l_start <
+               std::chrono::seconds(10));
+        assert(l_fits(l_model));
+    }
+
+    // reaching the target stops the search
+    {
+        program l_search_program = l_program;
+        scope l_search_scope = l_scope;
+
+        size_t l_improvements = 0;
+
+        model l_model = learn_model<bool, bool>(
+            l_search_program, l_search_scope, l_data,
+            search_config{
+                .m_recursion_limit = 3,
+                .m_exploration_constant = 100,
+                .m_target_reward = -1000,
+                .m_on_improvement = [&l_improvements](const double&,
+                                                      const program&,
+                                                      const model&)
+                { ++l_improvements; },
+            });
+
+        // the first model beats the target
+        assert(l_improvements == 1);
+        assert(l_fits(l_model));
+    }
+
+    // a stop request from another thread stops an unbounded search
+    {
+        program l_search_program = l_program;
+        scope l_search_scope = l_scope;
+
+        std::stop_source l_stop_source;
+
+        std::thread l_stopper(
+            [&l_stop_source]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                l_stop_source.request_stop();
+            });
+
+        model l_model = learn_model<bool, bool>(
+            l_search_program, l_search_scope, l_data,
+            search_config{
+                .m_recursion_limit = 3,
+                .m_exploration_constant = 100,
+                .m_stop_token = l_stop_source.get_token(),
+            });
+
+        l_stopper.join();
+
+        assert(l_fits(l_model));
+    }
+
+    // a capped tree still finds models
+    {
+        program l_search_program = l_program;
+        scope l_search_scope = l_scope;
+
+        model l_model = learn_model<bool, bool>(
+            l_search_program, l_search_scope, l_data,
+            search_config{
+                .m_iterations = 100,
+                .m_recursion_limit = 3,
+                .m_exploration_constant = 100,
+                .m_max_tree_nodes = 8,
+            });
+
+        assert(l_fits(l_model));
+    }
+}
+
+void test_learn_model_checkpoint()
+{
+    // learn a exor b, in one go and in two halves
+    constexpr size_t ITERATIONS = 200;
+    const std::string CHECKPOINT_PATH =
+        (std::filesystem::temp_directory_path() / "test_checkpoint").string();
+
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data{
+        {{false, false}, false},
+        {{false, true}, true},
+        {{true, false}, true},
+        {{true, true}, false},
+    };
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "or", std::function([](bool a_x, bool a_y) { return a_x || a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "not", std::function([](bool a_x) { return !a_x; })));
+
+    // record every improvement
+    std::vector<std::string> l_improvements;
+    auto l_record = [&l_improvements](const double& a_reward, const program&,
+                                      const model& a_model)
+    {
+        l_improvements.push_back(std::to_string(a_reward) + " " +
+                                 a_model.repr());
+    };
+
+    search_config l_config{
+        .m_iterations = ITERATIONS,
+        .m_recursion_limit = 3,
+        .m_exploration_constant = 10,
+        .m_on_improvement = l_record,
+    };
+
+    // uninterrupted
+    program l_whole_program = l_program;
+    scope l_whole_scope = l_scope;
+    model l_whole_model = learn_model<bool, bool>(
+        l_whole_program, l_whole_scope, l_data, l_config);
+    std::vector<std::string> l_whole_improvements = l_improvements;
+
+    // interrupted halfway, checkpointing every iteration
+    std::remove(CHECKPOINT_PATH.c_str());
+    l_improvements.clear();
+
+    l_config.m_checkpoint_path = CHECKPOINT_PATH;
+    l_config.m_checkpoint_interval = std::chrono::steady_clock::duration{};
+    l_config.m_iterations = ITERATIONS / 2;
+
+    {
+        program l_half_program = l_program;
+        scope l_half_scope = l_scope;
+        learn_model<bool, bool>(l_half_program, l_half_scope, l_data,
+                                l_config);
+    }
+
+    // resumed, in a fresh program, as after a restart
+    l_config.m_iterations = ITERATIONS;
+
+    program l_resumed_program = l_program;
+    scope l_resumed_scope = l_scope;
+    model l_resumed_model = learn_model<bool, bool>(
+        l_resumed_program, l_resumed_scope, l_data, l_config);
+
+    // the search continued exactly
+    assert(l_improvements == l_whole_improvements);
+    assert(l_resumed_model.repr() == l_whole_model.repr());
+    assert(model_reward(l_resumed_program, l_resumed_model) ==
+           model_reward(l_whole_program, l_whole_model));
+
+    // the best model's funcs belong to the resumed program
+    for(const auto& [l_x, l_y] : l_data)
+        assert(l_resumed_model.eval(l_x.data(), l_x.size()) == l_y);
+
+    // and the scope is the best model's, even if the resumed search
+    // makes no rollouts
+    assert(l_resumed_scope.m_non_nullaries == l_whole_scope.m_non_nullaries);
+
+    program l_restarted_program = l_program;
+    scope l_empty_scope;
+    learn_model<bool, bool>(l_restarted_program, l_empty_scope, l_data,
+                            l_config);
+    assert(l_empty_scope.m_non_nullaries == l_whole_scope.m_non_nullaries);
+
+    std::remove(CHECKPOINT_PATH.c_str());
+}
+
+void test_learn_model_duplicates()
+{
+    // learn a exor b from many copies of each data point
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data;
+    for(size_t i = 0; i < 100; ++i)
+        l_data.push_back({{i % 4 >= 2, i % 2 == 1}, i % 4 == 1 || i % 4 == 2});
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "not", std::function([](bool a_x) { return !a_x; })));
+
+    search_config l_config{
+        .m_iterations = 100,
+        .m_recursion_limit = 3,
+        .m_exploration_constant = 100,
+    };
+
+    // with and without collapsing duplicates
+    program l_collapsed_program = l_program;
+    scope l_collapsed_scope = l_scope;
+    search_stats l_collapsed_stats;
+    model l_collapsed_model = learn_model<bool, bool>(
+        l_collapsed_program, l_collapsed_scope, l_data, l_config, nullptr,
+        nullptr, &l_collapsed_stats);
+
+    l_config.m_collapse_duplicates = false;
+    program l_full_program = l_program;
+    scope l_full_scope = l_scope;
+    search_stats l_full_stats;
+    model l_full_model = learn_model<bool, bool>(
+        l_full_program, l_full_scope, l_data, l_config, nullptr, nullptr,
+        &l_full_stats);
+
+    // both models separate the data
+    for(const auto& [l_x, l_y] : l_data)
+    {
+        assert(l_collapsed_model.eval(l_x.data(), l_x.size()) == l_y);
+        assert(l_full_model.eval(l_x.data(), l_x.size()) == l_y);
+    }
+
+    // but only the distinct data points were binned
+    assert(l_collapsed_stats.m_rows_per_split.rbegin()->first == 4);
+    assert(l_full_stats.m_rows_per_split.rbegin()->first == 100);
+
+    // a conflict is rejected before the search
+    l_data.push_back({{false, true}, false});
+    l_config.m_collapse_duplicates = true;
+    assert_throws((learn_model<bool, bool>(l_program, l_scope, l_data,
+                                           l_config)),
+                  std::runtime_error);
+}
+
+void test_learn_model_sampling()
+{
+    // learn x < 500 from many distinct rows
+    constexpr size_t ROW_COUNT = 4000;
+    constexpr size_t SAMPLE_SIZE = 16;
+
+    typed_dataset<int> l_data;
+    for(size_t i = 0; i < ROW_COUNT; ++i)
+    {
+        std::get<0>(l_data.m_columns).push_back(i);
+        l_data.m_labels.push_back(i < 500);
+    }
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "<", std::function([](int a_x, int a_y) { return a_x < a_y; })));
+    l_scope.add_function(
+        l_program.add_primitive("500", std::function([]() { return 500; })));
+
+    search_stats l_stats;
+    model l_model = learn_model(l_program, l_scope, l_data,
+                                search_config{
+                                    .m_iterations = 200,
+                                    .m_recursion_limit = 3,
+                                    .m_exploration_constant = 10,
+                                    .m_binning = {.m_sample_size =
+                                                      SAMPLE_SIZE},
+                                },
+                                nullptr, nullptr, &l_stats);
+
+    // every split was verified on the whole bin, so the model fits
+    std::any l_param;
+    for(size_t i = 0; i < l_data.size(); ++i)
+    {
+        l_data.fill_row(i, &l_param);
+        assert(l_model.eval(&l_param, 1) == l_data.m_labels[i]);
+    }
+
+    // functions which split no sample were rejected without being
+    // evaluated on the whole bin
+    assert(l_stats.m_sample_rejections > 0);
+    assert(l_stats.m_rows_evaluated <
+           (l_stats.m_binning_functions + l_stats.m_binning_retries) *
+               ROW_COUNT);
+
+    // a sample holds each label in proportion, and at least once
+    std::vector<size_t> l_rows(ROW_COUNT);
+    std::iota(l_rows.begin(), l_rows.end(), 0);
+    std::vector<size_t> l_sample =
+        stratified_sample(l_data, l_rows, SAMPLE_SIZE);
+    // the rows of each label, spread evenly
+    assert(l_sample.size() == SAMPLE_SIZE);
+    for(size_t i = 0; i < SAMPLE_SIZE; ++i)
+        assert(l_sample[i] == (i < 14 ? 500 + i * 250 : (i - 14) * 250));
+    // a bin smaller than the sample is sampled whole
+    assert(stratified_sample(l_data, {0, 1000, 2000}, SAMPLE_SIZE) ==
+           std::vector<size_t>({1000, 2000, 0}));
+    assert(stratified_sample(l_data, l_rows, 1).size() == 2);
+}
+
+void test_learn_model_candidates()
+{
+    // a split which purifies its bins scores better than one which
+    // splits off a single row
+    assert(weighted_entropy(0, 0) == 0);
+    assert(weighted_entropy(5, 0) == 0);
+    assert(weighted_entropy(2, 2) == 4);
+    assert(weighted_entropy(4, 0) + weighted_entropy(0, 4) <
+           weighted_entropy(1, 0) + weighted_entropy(3, 4));
+
+    // learn x < 500, from constants which split the data anywhere
+    typed_dataset<int> l_data;
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        std::get<0>(l_data.m_columns).push_back(i);
+        l_data.m_labels.push_back(i < 500);
+    }
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "<", std::function([](int a_x, int a_y) { return a_x < a_y; })));
+    for(int l_constant : {100, 200, 300, 400, 500, 600, 700, 800, 900})
+        l_scope.add_function(l_program.add_primitive(
+            std::to_string(l_constant),
+            std::function([l_constant]() { return l_constant; })));
+
+    // the mean depth of the models of a search
+    auto l_mean_depth = [&](const size_t& a_candidate_count)
+    {
+        program l_search_program = l_program;
+        scope l_search_scope = l_scope;
+        search_stats l_stats;
+
+        model l_model = learn_model(
+            l_search_program, l_search_scope, l_data,
+            search_config{
+                .m_iterations = 100,
+                .m_recursion_limit = 2,
+                .m_exploration_constant = 10,
+                .m_binning = {.m_candidate_count = a_candidate_count},
+            },
+            nullptr, nullptr, &l_stats);
+
+        // the best model fits the data either way
+        std::any l_param;
+        for(size_t i = 0; i < l_data.size(); ++i)
+        {
+            l_data.fill_row(i, &l_param);
+            assert(l_model.eval(&l_param, 1) == l_data.m_labels[i]);
+        }
+
+        double l_depth_sum = 0;
+        for(const auto& [l_depth, l_count] : l_stats.m_model_depths)
+            l_depth_sum += l_depth * l_count;
+
+        return l_depth_sum / l_stats.m_iterations;
+    };
+
+    // keeping the best of many candidates gives shallower models
+    assert(l_mean_depth(8) < l_mean_depth(1));
+
+    // the candidates are scored on the data points each row stands for.
+    // below_2 splits the unique rows best, but below_1 purifies the bins
+    // of the data, in which the first row is repeated
+    typed_dataset<int> l_unique_data;
+    std::get<0>(l_unique_data.m_columns) = {0, 1, 2, 3};
+    l_unique_data.m_labels = {false, true, false, false};
+
+    program l_threshold_program;
+    scope l_threshold_scope;
+    for(int l_threshold : {1, 2})
+        l_threshold_scope.add_function(l_threshold_program.add_primitive(
+            "below_" + std::to_string(l_threshold),
+            std::function([l_threshold](int a_x)
+                          { return a_x < l_threshold; })));
+
+    // the function of the root split, given the weights of the rows
+    auto l_root_split = [&](const std::vector<size_t>& a_weights)
+    {
+        program l_split_program = l_threshold_program;
+        search_tree<choice> l_tree;
+        std::mt19937 l_rnd_gen(27);
+        rollout<choice, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+        std::multimap<std::type_index, size_t> l_param_types{
+            {typeid(int), 0}};
+
+        model l_model = build_model(
+            l_split_program, l_threshold_scope, l_param_types, l_unique_data,
+            {0, 1, 2, 3}, a_weights, l_rollout, 2,
+            -std::numeric_limits<double>::infinity(), nullptr, nullptr,
+            {.m_candidate_count = 16});
+
+        return l_model.m_func->m_repr;
+    };
+
+    assert(l_root_split({}) == "below_2(?0)");
+    assert(l_root_split({20, 1, 1, 1}) == "below_1(?0)");
+}
+
+void test_learn_model_impure_leaves()
+{
+    // learn x < 500 from data with every twentieth label flipped, and
+    // some rows repeated with the other label
+    typed_dataset<int> l_data;
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        std::get<0>(l_data.m_columns).push_back(i);
+        l_data.m_labels.push_back((i < 500) != (i % 20 == 7));
+    }
+    for(size_t i = 0; i < 1000; i += 100)
+    {
+        std::get<0>(l_data.m_columns).push_back(i);
+        l_data.m_labels.push_back(i >= 500);
+    }
+
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "<", std::function([](int a_x, int a_y) { return a_x < a_y; })));
+    for(int l_constant : {250, 500, 750})
+        l_scope.add_function(l_program.add_primitive(
+            std::to_string(l_constant),
+            std::function([l_constant]() { return l_constant; })));
+
+    search_stats l_stats;
+    model l_model = learn_model(l_program, l_scope, l_data,
+                                search_config{
+                                    .m_iterations = 200,
+                                    .m_recursion_limit = 2,
+                                    .m_exploration_constant = 10,
+                                    .m_binning =
+                                        {
+                                            .m_leaf_purity = 0.9,
+                                            .m_max_depth = 3,
+                                        },
+                                },
+                                nullptr, nullptr, &l_stats);
+
+    // every model stopped splitting, despite the conflicts
+    assert(l_stats.m_impure_leaves > 0);
+    assert(l_stats.m_model_depths.rbegin()->first <= 3);
+
+    // the leaves count the data points the model misclassifies
+    size_t l_errors = 0;
+    std::any l_param;
+    for(size_t i = 0; i < l_data.size(); ++i)
+    {
+        l_data.fill_row(i, &l_param);
+        l_errors += l_model.eval(&l_param, 1) != l_data.m_labels[i];
+    }
+    assert(l_errors == l_model.error_count());
+    assert(l_errors > 0);
+
+    // and are penalized in the reward
+    assert(model_reward(l_program, l_model, l_data, reward_mode::node_count,
+                        2) == model_reward(l_program, l_model) - 2 * l_errors);
+
+    // the best model splits at 500, leaving only the noise
+    assert(l_model.repr() == "[<(500(),?0)] ? {0} : {1}");
+    assert(l_errors == 60);
+
+    // a bin too small to split is a leaf
+    search_tree<choice> l_tree;
+    std::mt19937 l_rnd_gen(27);
+    rollout<choice, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+    std::multimap<std::type_index, size_t> l_param_types{{typeid(int), 0}};
+    model l_leaf = build_model(l_program, l_scope, l_param_types, l_data,
+                               l_rollout, 2,
+                               -std::numeric_limits<double>::infinity(),
+                               nullptr, nullptr,
+                               {.m_min_split_size = l_data.size() + 1});
+    // which is a tie, of 505 data points of each label
+    assert(l_leaf.m_func == nullptr);
+    assert(l_leaf.m_homogenous_value == false);
+    assert(l_leaf.error_count() == 505);
 }
 
 void reduce_test_main()
@@ -1174,6 +2608,372 @@ void reduce_test_main()
     // TEST(test_build_model);
     // TEST(test_evaluate);
     TEST(test_learn_model);
+    TEST(test_learn_model_baseline);
+    TEST(test_learn_model_stats);
+    TEST(test_learn_model_transpositions);
+    TEST(test_build_function_canonical);
+    TEST(test_learn_model_inference_cost);
+    TEST(test_calibrate_costs_by_search);
+    TEST(test_learn_model_trace);
+    TEST(test_learn_model_anytime);
+    TEST(test_learn_model_checkpoint);
+    TEST(test_learn_model_duplicates);
+    TEST(test_learn_model_sampling);
+    TEST(test_learn_model_candidates);
+    TEST(test_learn_model_impure_leaves);
+}
+
+#endif
+
+#ifdef BENCHMARK
+
+#include "bench_utils.hpp"
+#include <bit>
+
+void bench_build_function()
+{
+    for(size_t l_scope_size : {4, 16, 64, 256})
+    {
+        program l_program;
+        scope l_scope;
+
+        // fill the scope with constants, plus two connectives
+        l_scope.add_function(l_program.add_primitive(
+            "and",
+            std::function([](bool a_x, bool a_y) { return a_x && a_y; })));
+        l_scope.add_function(l_program.add_primitive(
+            "or",
+            std::function([](bool a_x, bool a_y) { return a_x || a_y; })));
+        for(size_t i = 2; i < l_scope_size; ++i)
+            l_scope.add_function(l_program.add_primitive(
+                "c" + std::to_string(i), std::function([]() { return true; })));
+
+        std::mt19937 l_rnd_gen(27);
+        std::multimap<std::type_index, size_t> l_param_types;
+
+        bench("build_function", {{"scope_size", l_scope_size}},
+              [&]()
+              {
+                  // REASON: a fresh tree, so that every choice is expanded
+                  search_tree<choice> l_tree;
+                  rollout<choice, std::mt19937> l_rollout(l_tree, 1,
+                                                          l_rnd_gen);
+                  std::stringstream l_repr_stream;
+
+                  do_not_optimize(build_function(
+                      l_program, l_scope, l_param_types, l_repr_stream,
+                      typeid(bool), false, l_rollout, 3));
+              });
+    }
+}
+
+void bench_build_model()
+{
+    program l_program;
+    scope l_scope;
+
+    l_scope.add_function(l_program.add_primitive(
+        "exor", std::function([](bool a_x, bool a_y) { return a_x != a_y; })));
+    l_scope.add_function(l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; })));
+
+    for(size_t l_row_count : {16, 256, 4096})
+    {
+        // 4-input parity, with the truth table repeated to fill the rows
+        std::vector<std::pair<std::vector<std::any>, bool>> l_data;
+        for(size_t i = 0; i < l_row_count; ++i)
+        {
+            std::vector<std::any> l_x;
+            bool l_y = false;
+            for(size_t j = 0; j < 4; ++j)
+            {
+                bool l_bit = (i >> j) & 1;
+                l_x.push_back(l_bit);
+                l_y = l_y != l_bit;
+            }
+            l_data.emplace_back(l_x, l_y);
+        }
+
+        std::mt19937 l_rnd_gen(27);
+        std::multimap<std::type_index, size_t> l_param_types{
+            {typeid(bool), 0},
+            {typeid(bool), 1},
+            {typeid(bool), 2},
+            {typeid(bool), 3},
+        };
+
+        // with and without evaluating a sample of each bin first, and
+        // keeping the best of many binning functions
+        for(const binning_config& l_binning :
+            {binning_config{}, binning_config{.m_sample_size = 64},
+             binning_config{.m_candidate_count = 8}})
+            bench("build_model",
+                  {
+                      {"row_count", l_row_count},
+                      {"sample_size", l_binning.m_sample_size},
+                      {"candidate_count", l_binning.m_candidate_count},
+                  },
+                  [&]()
+                  {
+                      search_tree<choice> l_tree;
+                      rollout<choice, std::mt19937> l_rollout(l_tree, 1,
+                                                              l_rnd_gen);
+                      program l_rollout_program = l_program;
+                      scope l_rollout_scope = l_scope;
+
+                      do_not_optimize(build_model(
+                          l_rollout_program, l_rollout_scope, l_param_types,
+                          l_data, l_rollout, 3,
+                          -std::numeric_limits<double>::infinity(), nullptr,
+                          nullptr, l_binning));
+                  });
+    }
+}
+
+// a param pack of N copies of a type
+template <size_t, typename T>
+using repeat = T;
+
+// measure the search on a workload with N params of type T. records
+// the rollout throughput, and the wall time until the best reward
+// reaches the reward of the enumerative engine's model.
+template <typename T, size_t... Is>
+void bench_search(const std::string& a_name,
+                  const std::map<std::string, double>& a_params,
+                  const program& a_program, const scope& a_scope,
+                  const std::vector<std::pair<std::vector<std::any>, bool>>&
+                      a_data,
+                  std::index_sequence<Is...>)
+{
+    constexpr size_t ITERATIONS = 200;
+    constexpr size_t ENUMERATION_SIZE = 7;
+    constexpr auto BUDGET = std::chrono::seconds(5);
+
+    const search_config CONFIG{
+        .m_iterations = ITERATIONS,
+        .m_recursion_limit = 10,
+        .m_exploration_constant = 100,
+    };
+
+    std::map<std::string, double> l_metrics;
+
+    // the peak is only that of this run if it can be reset
+    bool l_measure_rss = reset_peak_rss();
+
+    ////////////////////////////////////////////////////
+    //////////////// MEASURE THROUGHPUT ////////////////
+    ////////////////////////////////////////////////////
+    {
+        program l_program = a_program;
+        scope l_scope = a_scope;
+
+        auto l_start = std::chrono::steady_clock::now();
+        learn_model<repeat<Is, T>...>(l_program, l_scope, a_data, CONFIG);
+        std::chrono::duration<double> l_elapsed =
+            std::chrono::steady_clock::now() - l_start;
+
+        l_metrics["iterations_per_second"] = ITERATIONS / l_elapsed.count();
+    }
+
+    ////////////////////////////////////////////////////
+    ////////////// MEASURE TIME TO TARGET //////////////
+    ////////////////////////////////////////////////////
+    try
+    {
+        program l_program = a_program;
+
+        std::multimap<std::type_index, size_t> l_param_types;
+        (l_param_types.emplace(typeid(T), Is), ...);
+
+        model l_reference = enumerate_model(l_program, a_scope, l_param_types,
+                                            a_data, ENUMERATION_SIZE);
+        double l_target_reward = model_reward(l_program, l_reference);
+
+        program l_search_program = a_program;
+        scope l_search_scope = a_scope;
+        incumbent l_incumbent(std::chrono::steady_clock::now() + BUDGET,
+                              l_target_reward);
+
+        search_config l_config = CONFIG;
+        l_config.m_iterations = std::numeric_limits<size_t>::max();
+
+        auto l_start = std::chrono::steady_clock::now();
+        learn_model<repeat<Is, T>...>(l_search_program, l_search_scope,
+                                      a_data, l_config, nullptr,
+                                      &l_incumbent);
+        std::chrono::duration<double> l_elapsed =
+            std::chrono::steady_clock::now() - l_start;
+
+        l_metrics["target_reward"] = l_target_reward;
+        l_metrics["best_reward"] = l_incumbent.m_reward.load();
+        l_metrics["reached_target"] =
+            l_incumbent.m_reward.load() >= l_target_reward;
+        l_metrics["seconds_to_target"] = l_elapsed.count();
+    }
+    catch(const std::runtime_error&)
+    {
+        // REASON: without a reference model there is no target
+    }
+
+    if(l_measure_rss)
+        l_metrics["peak_rss_kb"] = peak_rss_kb();
+
+    bench_results().push_back(bench_result{
+        .m_name = a_name,
+        .m_params = a_params,
+        .m_metrics = l_metrics,
+    });
+}
+
+// build the full truth table of an N-input bool function, repeated
+// to fill the rows
+std::vector<std::pair<std::vector<std::any>, bool>>
+make_bool_data(size_t a_input_count, size_t a_repeats,
+               const std::function<bool(size_t)>& a_function)
+{
+    std::vector<std::pair<std::vector<std::any>, bool>> l_data;
+
+    for(size_t l_repeat = 0; l_repeat < a_repeats; ++l_repeat)
+    {
+        for(size_t l_key = 0; l_key < (size_t{1} << a_input_count); ++l_key)
+        {
+            std::vector<std::any> l_x;
+            for(size_t i = 0; i < a_input_count; ++i)
+                l_x.push_back(bool((l_key >> i) & 1));
+            l_data.emplace_back(l_x, a_function(l_key));
+        }
+    }
+
+    return l_data;
+}
+
+template <size_t N>
+void bench_bool_family(const std::string& a_name, const program& a_program,
+                       const scope& a_scope,
+                       const std::function<bool(size_t)>& a_function,
+                       const std::map<std::string, double>& a_params)
+{
+    for(size_t l_repeats : {1, 8})
+    {
+        auto l_data = make_bool_data(N, l_repeats, a_function);
+
+        std::map<std::string, double> l_params = a_params;
+        l_params["input_count"] = N;
+        l_params["row_count"] = l_data.size();
+
+        bench_search<bool>(a_name, l_params, a_program, a_scope, l_data,
+                           std::make_index_sequence<N>());
+    }
+}
+
+void bench_learn_model()
+{
+    ////////////////////////////////////////////////////
+    ////////////////// BOOL WORKLOADS //////////////////
+    ////////////////////////////////////////////////////
+    {
+        program l_program;
+        scope l_scope;
+
+        // all of them are commutative and associative
+        const func::properties PROPERTIES{
+            .m_commutative = true,
+            .m_associative = true,
+        };
+
+        l_scope.add_function(l_program.add_primitive(
+            "exor",
+            std::function([](bool a_x, bool a_y) { return a_x != a_y; }),
+            PROPERTIES));
+        l_scope.add_function(l_program.add_primitive(
+            "and",
+            std::function([](bool a_x, bool a_y) { return a_x && a_y; }),
+            PROPERTIES));
+        l_scope.add_function(l_program.add_primitive(
+            "or",
+            std::function([](bool a_x, bool a_y) { return a_x || a_y; }),
+            PROPERTIES));
+
+        auto l_parity = [](size_t a_key) { return std::popcount(a_key) % 2; };
+
+        bench_bool_family<2>("learn_model/parity", l_program, l_scope,
+                             l_parity, {});
+        bench_bool_family<3>("learn_model/parity", l_program, l_scope,
+                             l_parity, {});
+        bench_bool_family<4>("learn_model/parity", l_program, l_scope,
+                             l_parity, {});
+
+        // true if at least a_threshold inputs are true
+        auto l_threshold = [](size_t a_threshold)
+        {
+            return [a_threshold](size_t a_key)
+            { return size_t(std::popcount(a_key)) >= a_threshold; };
+        };
+
+        bench_bool_family<3>("learn_model/majority", l_program, l_scope,
+                             l_threshold(2), {});
+        bench_bool_family<5>("learn_model/majority", l_program, l_scope,
+                             l_threshold(3), {});
+
+        bench_bool_family<4>("learn_model/threshold", l_program, l_scope,
+                             l_threshold(1), {{"threshold", 1}});
+        bench_bool_family<4>("learn_model/threshold", l_program, l_scope,
+                             l_threshold(3), {{"threshold", 3}});
+    }
+
+    ////////////////////////////////////////////////////
+    /////////////////// INT WORKLOADS //////////////////
+    ////////////////////////////////////////////////////
+    {
+        program l_program;
+        scope l_scope;
+
+        l_scope.add_function(
+            l_program.add_primitive("0", std::function([]() { return 0; })));
+        l_scope.add_function(l_program.add_primitive(
+            "succ", std::function([](int a_n) { return a_n + 1; })));
+        l_scope.add_function(l_program.add_primitive(
+            ">", std::function([](int a_x, int a_y) { return a_x > a_y; })));
+        l_scope.add_function(l_program.add_primitive(
+            "<", std::function([](int a_x, int a_y) { return a_x < a_y; })));
+
+        for(int l_radius : {8, 32, 128})
+        {
+            // 0 < x < 3
+            std::vector<std::pair<std::vector<std::any>, bool>> l_range_data;
+            for(int l_x = -l_radius; l_x < l_radius; ++l_x)
+                l_range_data.push_back({{l_x}, 0 < l_x && l_x < 3});
+
+            bench_search<int>("learn_model/int_range",
+                              {
+                                  {"input_count", 1},
+                                  {"row_count", l_range_data.size()},
+                              },
+                              l_program, l_scope, l_range_data,
+                              std::make_index_sequence<1>());
+
+            // x < y + 1
+            std::vector<std::pair<std::vector<std::any>, bool>> l_order_data;
+            for(int l_x = -l_radius / 4; l_x < l_radius / 4; ++l_x)
+                for(int l_y = -l_radius / 4; l_y < l_radius / 4; ++l_y)
+                    l_order_data.push_back({{l_x, l_y}, l_x < l_y + 1});
+
+            bench_search<int>("learn_model/int_order",
+                              {
+                                  {"input_count", 2},
+                                  {"row_count", l_order_data.size()},
+                              },
+                              l_program, l_scope, l_order_data,
+                              std::make_index_sequence<2>());
+        }
+    }
+}
+
+void reduce_bench_main()
+{
+    BENCH(bench_build_function);
+    BENCH(bench_build_model);
+    BENCH(bench_learn_model);
 }
 
 #endif
@@ -0,0 +1,118 @@
+#include "../include/search_stats.hpp"
+#include <sstream>
+
+std::string search_stats::repr() const
+{
+    std::stringstream l_stream;
+
+    // write a timer in milliseconds
+    auto l_write_timer =
+        [&l_stream](const std::string& a_name,
+                    const std::chrono::steady_clock::duration& a_timer)
+    {
+        l_stream << a_name << ": "
+                 << std::chrono::duration<double, std::milli>(a_timer).count()
+                 << "ms" << std::endl;
+    };
+
+    // write a histogram as value:count pairs
+    auto l_write_histogram =
+        [&l_stream](const std::string& a_name, const histogram& a_histogram)
+    {
+        l_stream << a_name << ":";
+        for(const auto& [l_value, l_count] : a_histogram)
+            l_stream << " " << l_value << ":" << l_count;
+        l_stream << std::endl;
+    };
+
+    l_stream << "iterations: " << m_iterations << std::endl;
+    l_stream << "pruned rollouts: " << m_pruned_rollouts << std::endl;
+    l_stream << "improvements: " << m_improvements << std::endl;
+    l_stream << "binning functions: " << m_binning_functions << std::endl;
+    l_stream << "binning retries: " << m_binning_retries << std::endl;
+    l_stream << "sample rejections: " << m_sample_rejections << std::endl;
+    l_stream << "impure leaves: " << m_impure_leaves << std::endl;
+    l_stream << "rows evaluated: " << m_rows_evaluated << std::endl;
+    l_stream << "transpositions: " << m_transpositions << std::endl;
+
+    l_write_timer("rollout time", m_rollout_time);
+    l_write_timer("build function time", m_build_function_time);
+    l_write_timer("bin evaluation time", m_bin_evaluation_time);
+    l_write_timer("program copy time", m_program_copy_time);
+    l_write_timer("node count time", m_node_count_time);
+
+    l_write_histogram("model depths", m_model_depths);
+    l_write_histogram("binning function sizes", m_binning_function_sizes);
+    l_write_histogram("retry counts", m_retry_counts);
+    l_write_histogram("rows per split", m_rows_per_split);
+
+    return l_stream.str();
+}
+
+scoped_timer::scoped_timer(std::chrono::steady_clock::duration* a_timer)
+    : m_timer(a_timer)
+{
+    // REASON: reading the clock is the cost we avoid when disabled
+    if(m_timer != nullptr)
+        m_start = std::chrono::steady_clock::now();
+}
+
+scoped_timer::~scoped_timer()
+{
+    if(m_timer != nullptr)
+        *m_timer += std::chrono::steady_clock::now() - m_start;
+}
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+#include <thread>
+
+void test_scoped_timer()
+{
+    // a null timer is ignored
+    {
+        scoped_timer l_timer(nullptr);
+    }
+
+    // time accumulates over scopes
+    std::chrono::steady_clock::duration l_total{};
+
+    {
+        scoped_timer l_timer(&l_total);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    auto l_first = l_total;
+    assert(l_first >= std::chrono::milliseconds(2));
+
+    {
+        scoped_timer l_timer(&l_total);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    assert(l_total >= l_first + std::chrono::milliseconds(2));
+}
+
+void test_search_stats_repr()
+{
+    search_stats l_stats;
+    l_stats.m_iterations = 12;
+    l_stats.m_retry_counts = {{0, 5}, {3, 1}};
+
+    std::string l_repr = l_stats.repr();
+
+    assert(l_repr.find("iterations: 12\n") != std::string::npos);
+    assert(l_repr.find("retry counts: 0:5 3:1\n") != std::string::npos);
+    assert(l_repr.find("model depths:\n") != std::string::npos);
+}
+
+void search_stats_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_scoped_timer);
+    TEST(test_search_stats_repr);
+}
+
+#endif
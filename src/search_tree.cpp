@@ -0,0 +1,261 @@
+#include "../include/search_tree.hpp"
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+
+// check that the links of the live nodes agree, and that no node has
+// more visits than its parent
+void check_search_tree(const search_tree<int>& a_tree)
+{
+    size_t l_live_count = 0;
+
+    for(size_t i = 0; i < a_tree.m_values.size(); ++i)
+    {
+        if(!a_tree.is_live(i))
+            continue;
+
+        ++l_live_count;
+
+        for(size_t j = 0; j < a_tree.m_children[i].size(); ++j)
+        {
+            size_t l_child = a_tree.m_children[i][j];
+
+            assert(a_tree.m_parents[l_child] == i);
+            assert(a_tree.m_visits[l_child] <= a_tree.m_visits[i]);
+            assert(a_tree.child(i, a_tree.m_choices[l_child]) == l_child);
+
+            // the children are in order of their choices
+            if(j > 0)
+                assert(a_tree.m_choices[a_tree.m_children[i][j - 1]] <
+                       a_tree.m_choices[l_child]);
+        }
+    }
+
+    assert(l_live_count == a_tree.size());
+}
+
+void test_search_tree_growth()
+{
+    std::mt19937 l_rnd_gen(27);
+    const std::vector<int> CHOICES{0, 1, 2};
+
+    // each rollout adds a single node
+    {
+        search_tree<int> l_tree;
+        assert(l_tree.size() == 1);
+
+        for(size_t i = 1; i <= 5; ++i)
+        {
+            rollout<int, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+
+            // a descent of three choices
+            for(size_t j = 0; j < 3; ++j)
+            {
+                int l_choice = l_rollout.choose(CHOICES);
+                assert(l_choice >= 0 && l_choice <= 2);
+            }
+
+            l_rollout.terminate(-1);
+
+            assert(l_tree.size() == 1 + i);
+            assert(l_tree.m_visits[0] == i);
+            assert(l_tree.m_values[0] == -double(i));
+        }
+
+        // the root was fully expanded first
+        for(int l_choice : CHOICES)
+            assert(l_tree.child(0, l_choice) != search_tree<int>::NONE);
+
+        check_search_tree(l_tree);
+    }
+
+    // with nothing to evict, the tree stops growing at its cap, but
+    // rollouts go on
+    {
+        search_tree<int> l_tree(1);
+
+        for(size_t i = 0; i < 10; ++i)
+        {
+            rollout<int, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+            l_rollout.choose(CHOICES);
+            l_rollout.choose(CHOICES);
+            l_rollout.terminate(0);
+        }
+
+        assert(l_tree.size() == 1);
+        assert(l_tree.m_visits[0] == 10);
+    }
+}
+
+void test_search_tree_selection()
+{
+    std::mt19937 l_rnd_gen(27);
+    const std::vector<int> CHOICES{0, 1};
+
+    search_tree<int> l_tree;
+
+    // choice 1 is always rewarded more
+    for(size_t i = 0; i < 100; ++i)
+    {
+        rollout<int, std::mt19937> l_rollout(l_tree, 0.5, l_rnd_gen);
+        int l_choice = l_rollout.choose(CHOICES);
+        l_rollout.terminate(l_choice == 1 ? -1 : -2);
+    }
+
+    size_t l_good_visits = l_tree.m_visits[l_tree.child(0, 1)];
+    size_t l_bad_visits = l_tree.m_visits[l_tree.child(0, 0)];
+
+    assert(l_good_visits + l_bad_visits == 100);
+    assert(l_good_visits > 4 * l_bad_visits);
+}
+
+void test_search_tree_eviction()
+{
+    std::mt19937 l_rnd_gen(27);
+    const std::vector<int> CHOICES{0, 1, 2, 3};
+    constexpr size_t MAX_NODES = 16;
+
+    search_tree<int> l_tree(MAX_NODES);
+
+    // rollouts which start with choice 3 are rewarded more
+    for(size_t i = 0; i < 500; ++i)
+    {
+        rollout<int, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+
+        int l_first = l_rollout.choose(CHOICES);
+        for(size_t j = 0; j < 3; ++j)
+            l_rollout.choose(CHOICES);
+
+        l_rollout.terminate(l_first == 3 ? -1 : -3);
+
+        // the memory stays fixed
+        assert(l_tree.size() <= MAX_NODES);
+        assert(l_tree.m_values.size() <= MAX_NODES);
+    }
+
+    check_search_tree(l_tree);
+
+    // cold subtrees were evicted, and the root kept every visit
+    assert(l_tree.m_evicted > 0);
+    assert(l_tree.m_visits[0] == 500);
+
+    // the hot subtree survived
+    size_t l_hot = l_tree.child(0, 3);
+    assert(l_hot != search_tree<int>::NONE);
+    assert(l_tree.m_visits[l_hot] > 250);
+}
+
+void test_search_tree_evict()
+{
+    search_tree<int> l_tree;
+
+    // root -> 0 (10 visits) -> 0 (1 visit)
+    //      -> 1 (2 visits)
+    size_t l_hot = l_tree.add_child(0, 0);
+    size_t l_hot_child = l_tree.add_child(l_hot, 0);
+    size_t l_cold = l_tree.add_child(0, 1);
+    l_tree.m_visits = {12, 10, 1, 2};
+
+    // the path protects the hot leaf and its ancestors
+    assert(l_tree.evict({l_hot_child}));
+    assert(l_tree.size() == 3);
+    assert(l_tree.child(0, 1) == search_tree<int>::NONE);
+    assert(l_tree.m_free == std::vector<size_t>({l_cold}));
+
+    // nothing is left to evict
+    assert(!l_tree.evict({l_hot_child}));
+
+    // the slot is reused
+    assert(l_tree.add_child(0, 2) == l_cold);
+    assert(l_tree.m_free.empty());
+}
+
+void test_search_tree_transpose()
+{
+    std::mt19937 l_rnd_gen(27);
+
+    search_tree<int> l_tree;
+
+    // the first state of a key gets the key
+    size_t l_first;
+    {
+        rollout<int, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+        l_rollout.choose({0});
+        l_first = l_rollout.m_path.back();
+
+        assert(!l_rollout.transpose(7));
+        assert(l_rollout.m_state_key == 7);
+
+        l_rollout.terminate(-1);
+    }
+    assert(l_tree.m_transposition_table.at(7) == l_first);
+
+    // an equivalent state reached by another choice continues from the
+    // first state's node
+    {
+        rollout<int, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+        l_rollout.choose({1});
+        size_t l_second = l_rollout.m_path.back();
+
+        assert(l_rollout.transpose(7));
+        assert(l_rollout.m_path.back() == l_first);
+
+        // the rollout already added a node, so it goes on at random
+        l_rollout.choose({0, 1});
+        assert(!l_rollout.m_in_tree);
+
+        l_rollout.terminate(-2);
+
+        assert(l_tree.m_visits[l_second] == 1);
+    }
+    assert(l_tree.m_visits[l_first] == 2);
+    assert(l_tree.m_values[l_first] == -3);
+
+    // a rollout which left the tree enters it again at a known state,
+    // but an unknown state is not added
+    {
+        rollout<int, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+        l_rollout.choose({2});
+        l_rollout.choose({0});
+        assert(!l_rollout.m_in_tree);
+
+        assert(!l_rollout.transpose(8));
+        assert(l_tree.m_transposition_table.count(8) == 0);
+
+        assert(l_rollout.transpose(7));
+        assert(l_rollout.m_in_tree);
+        assert(l_rollout.m_path.back() == l_first);
+
+        l_rollout.terminate(-1);
+    }
+    assert(l_tree.m_visits[l_first] == 3);
+
+    // evicting a node forgets its key
+    l_tree.unlink(l_first);
+    l_tree.release(l_first);
+    assert(l_tree.m_transposition_table.empty());
+
+    // disabled, states never share nodes
+    l_tree.m_use_transpositions = false;
+    {
+        rollout<int, std::mt19937> l_rollout(l_tree, 1, l_rnd_gen);
+        l_rollout.choose({3});
+        assert(!l_rollout.transpose(9));
+        l_rollout.terminate(-1);
+    }
+    assert(l_tree.m_transposition_table.empty());
+}
+
+void search_tree_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_search_tree_growth);
+    TEST(test_search_tree_selection);
+    TEST(test_search_tree_eviction);
+    TEST(test_search_tree_evict);
+    TEST(test_search_tree_transpose);
+}
+
+#endif
@@ -0,0 +1,203 @@
+#include "../include/trace.hpp"
+#include <iomanip>
+#include <limits>
+
+trace::trace() : m_origin(std::chrono::steady_clock::now())
+{
+}
+
+void trace::record(const char* a_name,
+                   const std::chrono::steady_clock::time_point& a_start,
+                   const std::chrono::steady_clock::time_point& a_end,
+                   const std::map<std::string, double>& a_args)
+{
+    std::lock_guard<std::mutex> l_lock(m_mutex);
+
+    // number the thread if it is new
+    auto l_thread = m_threads
+                        .try_emplace(std::this_thread::get_id(),
+                                     m_threads.size())
+                        .first->second;
+
+    m_events.push_back(event{
+        .m_name = a_name,
+        .m_start = a_start,
+        .m_duration = a_end - a_start,
+        .m_thread = l_thread,
+        .m_args = a_args,
+    });
+}
+
+void trace::write(std::ostream& a_stream)
+{
+    std::lock_guard<std::mutex> l_lock(m_mutex);
+
+    // convert to the format's microseconds
+    auto l_microseconds = [](const std::chrono::steady_clock::duration& a_time)
+    { return std::chrono::duration<double, std::micro>(a_time).count(); };
+
+    // REASON: at the default precision of 6 digits, timestamps past 10
+    // seconds lose their microseconds and then go to exponents, so times
+    // are written to the nanosecond, and args to every digit an integer
+    // count needs. the stream's format is put back after.
+    std::ios l_format(nullptr);
+    l_format.copyfmt(a_stream);
+
+    a_stream << "{\"traceEvents\":[";
+
+    for(size_t i = 0; i < m_events.size(); ++i)
+    {
+        const event& l_event = m_events[i];
+
+        if(i > 0)
+            a_stream << ",";
+
+        // REASON: "X" events are complete spans, with a duration
+        a_stream << "\n{\"name\":\"" << l_event.m_name
+                 << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << l_event.m_thread
+                 << std::fixed << std::setprecision(3)
+                 << ",\"ts\":" << l_microseconds(l_event.m_start - m_origin)
+                 << ",\"dur\":" << l_microseconds(l_event.m_duration)
+                 << std::defaultfloat
+                 << std::setprecision(std::numeric_limits<double>::digits10)
+                 << ",\"args\":{";
+
+        for(auto l_it = l_event.m_args.begin(); l_it != l_event.m_args.end();
+            ++l_it)
+        {
+            if(l_it != l_event.m_args.begin())
+                a_stream << ",";
+            a_stream << "\"" << l_it->first << "\":" << l_it->second;
+        }
+
+        a_stream << "}}";
+    }
+
+    a_stream << "\n]}" << std::endl;
+
+    a_stream.copyfmt(l_format);
+}
+
+trace_span::trace_span(trace* a_trace, const char* a_name)
+    : m_trace(a_trace), m_name(a_name)
+{
+    if(m_trace != nullptr)
+        m_start = std::chrono::steady_clock::now();
+}
+
+trace_span::~trace_span()
+{
+    if(m_trace != nullptr)
+        m_trace->record(m_name, m_start, std::chrono::steady_clock::now(),
+                        m_args);
+}
+
+void trace_span::arg(const std::string& a_key, const double& a_value)
+{
+    if(m_trace != nullptr)
+        m_args[a_key] = a_value;
+}
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+#include <sstream>
+
+void test_trace_span()
+{
+    // a null trace is ignored
+    {
+        trace_span l_span(nullptr, "ignored");
+        l_span.arg("value", 1);
+        assert(l_span.m_args.empty());
+    }
+
+    trace l_trace;
+
+    // spans nest, the inner one completes first
+    {
+        trace_span l_outer(&l_trace, "outer");
+        l_outer.arg("rows", 4);
+
+        {
+            trace_span l_inner(&l_trace, "inner");
+        }
+    }
+
+    assert(l_trace.m_events.size() == 2);
+    assert(std::string(l_trace.m_events[0].m_name) == "inner");
+    assert(std::string(l_trace.m_events[1].m_name) == "outer");
+    assert(l_trace.m_events[1].m_args.at("rows") == 4);
+    assert(l_trace.m_events[1].m_start <= l_trace.m_events[0].m_start);
+    assert(l_trace.m_events[1].m_duration >= l_trace.m_events[0].m_duration);
+}
+
+void test_trace_threads()
+{
+    trace l_trace;
+
+    {
+        trace_span l_span(&l_trace, "main");
+    }
+
+    std::thread l_thread([&l_trace]()
+                         { trace_span l_span(&l_trace, "other"); });
+    l_thread.join();
+
+    // each thread gets its own number
+    assert(l_trace.m_events.size() == 2);
+    assert(l_trace.m_events[0].m_thread == 0);
+    assert(l_trace.m_events[1].m_thread == 1);
+}
+
+void test_trace_write()
+{
+    trace l_trace;
+
+    {
+        trace_span l_span(&l_trace, "iteration");
+        l_span.arg("index", 3);
+    }
+
+    std::stringstream l_stream;
+    l_trace.write(l_stream);
+
+    std::string l_json = l_stream.str();
+    assert(l_json.find("{\"traceEvents\":[") == 0);
+    assert(l_json.find("\"name\":\"iteration\",\"ph\":\"X\",\"pid\":0,"
+                       "\"tid\":0,\"ts\":") != std::string::npos);
+    assert(l_json.find("\"args\":{\"index\":3}}") != std::string::npos);
+
+    // late and long spans keep every microsecond, as do large args
+    l_trace.m_events.push_back(trace::event{
+        .m_name = "late",
+        .m_start = l_trace.m_origin + std::chrono::nanoseconds(12345678900),
+        .m_duration = std::chrono::nanoseconds(3600000000001),
+        .m_thread = 0,
+        .m_args = {{"rows", 1234567890}, {"reward", -0.5}},
+    });
+
+    l_stream.str("");
+    l_trace.write(l_stream);
+    l_json = l_stream.str();
+
+    assert(l_json.find("\"ts\":12345678.900,\"dur\":3600000000.001,") !=
+           std::string::npos);
+    assert(l_json.find("\"args\":{\"reward\":-0.5,\"rows\":1234567890}}") !=
+           std::string::npos);
+
+    // the stream's format is left as it was
+    assert(l_stream.precision() == 6);
+    assert(!(l_stream.flags() & std::ios::fixed));
+}
+
+void trace_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_trace_span);
+    TEST(test_trace_threads);
+    TEST(test_trace_write);
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include "../include/truth_table.hpp"
+#include <stdexcept>
+
+truth_table::truth_table(const model& a_model, size_t a_input_count)
+    : m_input_count(a_input_count)
+{
+    if(a_input_count > MAX_INPUT_COUNT)
+        throw std::runtime_error("Error: too many inputs to tabulate model.");
+
+    // the number of input combinations
+    const uint64_t l_row_count = uint64_t{1} << a_input_count;
+
+    // allocate one bit per row, rounded up to a whole word
+    m_bits.assign((l_row_count + 63) / 64, 0);
+
+    // a single input vector, reused for every row
+    std::vector<std::any> l_input(a_input_count);
+
+    for(uint64_t l_key = 0; l_key < l_row_count; ++l_key)
+    {
+        // unpack the key into the bool inputs
+        for(size_t i = 0; i < a_input_count; ++i)
+            l_input[i] = bool((l_key >> i) & 1);
+
+        // store the output bit
+        if(a_model.eval(l_input.data(), l_input.size()))
+            m_bits[l_key / 64] |= uint64_t{1} << (l_key % 64);
+    }
+}
+
+uint64_t truth_table::key(const std::any* a_params, size_t a_param_count)
+{
+    uint64_t l_key = 0;
+
+    for(size_t i = 0; i < a_param_count; ++i)
+        l_key |= uint64_t(std::any_cast<bool>(a_params[i])) << i;
+
+    return l_key;
+}
+
+bool truth_table::eval(uint64_t a_key) const
+{
+    return (m_bits[a_key / 64] >> (a_key % 64)) & 1;
+}
+
+bool truth_table::eval(const std::any* a_params, size_t a_param_count) const
+{
+    if(a_param_count != m_input_count)
+        throw std::runtime_error("Error: truth table given the wrong number "
+                                 "of inputs.");
+
+    return eval(key(a_params, a_param_count));
+}
+
+void truth_table::eval(const uint64_t* a_keys, size_t a_key_count,
+                       bool* a_results) const
+{
+    // gather the bits for each key
+    for(size_t i = 0; i < a_key_count; ++i)
+        a_results[i] = eval(a_keys[i]);
+}
+
+#ifdef UNIT_TEST
+
+#include "../include/program.hpp"
+#include "test_utils.hpp"
+
+void test_truth_table_construction()
+{
+    // homogenous models
+    {
+        truth_table l_falsy(model{.m_homogenous_value = false}, 3);
+        truth_table l_truthy(model{.m_homogenous_value = true}, 3);
+
+        assert(l_falsy.m_input_count == 3);
+        assert(l_falsy.m_bits.size() == 1);
+        assert(l_falsy.m_bits[0] == 0);
+        assert(l_truthy.m_bits[0] == 0xFF);
+    }
+
+    // more than one word of bits
+    {
+        truth_table l_table(model{.m_homogenous_value = true}, 8);
+        assert(l_table.m_bits.size() == 4);
+        for(uint64_t l_word : l_table.m_bits)
+            assert(l_word == ~uint64_t{0});
+    }
+
+    // too many inputs
+    {
+        assert_throws(truth_table(model{.m_homogenous_value = false},
+                                  truth_table::MAX_INPUT_COUNT + 1),
+                      std::runtime_error);
+    }
+}
+
+void test_truth_table_eval()
+{
+    program l_program;
+
+    // add a three-way exor binning function
+    auto l_exor_3 = l_program.add_primitive(
+        "exor_3", std::function([](bool a_x, bool a_y, bool a_z)
+                                { return (a_x != a_y) != a_z; }));
+
+    // add a conjunction binning function
+    auto l_and = l_program.add_primitive(
+        "and", std::function([](bool a_x, bool a_y) { return a_x && a_y; }));
+
+    // construct the model exor_3 ? 1 : and
+    model l_model{.m_func = l_exor_3};
+    l_model.m_positive_child =
+        std::make_shared<model>(model{.m_homogenous_value = true});
+    l_model.m_negative_child = std::make_shared<model>(model{.m_func = l_and});
+    l_model.m_negative_child->m_negative_child =
+        std::make_shared<model>(model{.m_homogenous_value = false});
+    l_model.m_negative_child->m_positive_child =
+        std::make_shared<model>(model{.m_homogenous_value = true});
+
+    truth_table l_table(l_model, 3);
+
+    // the table must agree with the model on every input
+    std::vector<uint64_t> l_keys;
+    std::vector<bool> l_expected;
+    for(bool l_x : {false, true})
+        for(bool l_y : {false, true})
+            for(bool l_z : {false, true})
+            {
+                std::vector<std::any> l_input{l_x, l_y, l_z};
+                bool l_result = l_model.eval(l_input.data(), l_input.size());
+                assert(l_table.eval(l_input.data(), l_input.size()) ==
+                       l_result);
+                l_keys.push_back(
+                    truth_table::key(l_input.data(), l_input.size()));
+                l_expected.push_back(l_result);
+            }
+
+    // key packing
+    {
+        std::vector<std::any> l_input{true, false, true};
+        assert(truth_table::key(l_input.data(), l_input.size()) == 5);
+    }
+
+    // batch lookup
+    {
+        std::unique_ptr<bool[]> l_results(new bool[l_keys.size()]);
+        l_table.eval(l_keys.data(), l_keys.size(), l_results.get());
+        for(size_t i = 0; i < l_keys.size(); ++i)
+            assert(l_results[i] == l_expected[i]);
+    }
+
+    // a wrong number of inputs
+    {
+        std::vector<std::any> l_input{true, false};
+        assert_throws(l_table.eval(l_input.data(), l_input.size()),
+                      std::runtime_error);
+    }
+}
+
+void truth_table_test_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_truth_table_construction);
+    TEST(test_truth_table_eval);
+}
+
+#endif